@@ -54,8 +54,8 @@ namespace osc {
             return OscServerManager<S>::getInstance().getServer(port);
         }
 
-        template <typename... Ts>
-        void subscribe(const uint16_t port, const String& addr, Ts&&... ts) {
+        template <typename Addr, typename... Ts>
+        void subscribe(const uint16_t port, const Addr& addr, Ts&&... ts) {
 #if defined(ARDUINOOSC_ENABLE_WIFI) && (defined(ESP_PLATFORM) || defined(ARDUINO_ARCH_RP2040))
             if (WiFi.getMode() != WIFI_OFF)
                 OscServerManager<S>::getInstance().getServer(port).subscribe(addr, std::forward<Ts>(ts)...);
@@ -117,14 +117,75 @@ namespace osc {
 #endif
         }
 
+        // read all pending packets of all ports within the budget (max_micros = 0 means no time limit)
+        // returns the number of handled packets
+        size_t parse(const size_t max_packets, const uint32_t max_micros = 0) {
+#if defined(ARDUINOOSC_ENABLE_WIFI) && (defined(ESP_PLATFORM) || defined(ARDUINO_ARCH_RP2040))
+            if (this->isWiFiConnected() || this->isWiFiModeAP()) {
+                return OscServerManager<S>::getInstance().parse(max_packets, max_micros);
+            } else {
+                LOG_ERROR(F("WiFi is not connected. Please connected to WiFi"));
+                return 0;
+            }
+#else
+            return OscServerManager<S>::getInstance().parse(max_packets, max_micros);
+#endif
+        }
+
+        // cache the callbacks of up to n recent addresses per port, 0 disables it
+        void dispatchCache(const size_t n) {
+            OscServerManager<S>::getInstance().dispatchCache(n);
+        }
+
+#ifdef ARDUINOOSC_HAVE_THREAD
+        // run the callbacks in n worker threads, 0 runs them in parse()
+        bool dispatchWorkers(const size_t n, const size_t queue_size = ARDUINOOSC_DISPATCH_QUEUE_SIZE) {
+            return OscServerManager<S>::getInstance().dispatchWorkers(n, queue_size);
+        }
+#endif
+
+        // treat the address of received messages as a pattern to the subscribed addresses (OSC 1.0)
+        void messagePatterns(const bool b) {
+            OscServerManager<S>::getInstance().messagePatterns(b);
+        }
+
+#ifndef ARDUINOOSC_DISABLE_BUNDLE
+        void scheduler(const OscScheduler::Clock clock, const OscLatePolicy policy = OscLatePolicy::RUN_NOW) {
+            OscServerManager<S>::getInstance().scheduler(clock, policy);
+        }
+#endif
+
         // client
 
         OscClient<S>& getClient() {
             return OscClientManager<S>::getInstance().getClient();
         }
 
-        template <typename... Ts>
-        void send(const String& ip, const uint16_t port, const String& addr, Ts&&... ts) {
+#ifdef ARDUINOOSC_HAVE_THREAD
+        // let multiple threads send at the same time (see Client::concurrent())
+        void concurrentSend(const bool b) {
+            OscClientManager<S>::getInstance().concurrent(b);
+        }
+
+        // send() only queues the packet, which is sent by the flusher thread (or by flush() if with_thread is false)
+        bool startSendQueue(const size_t queue_size = ARDUINOOSC_SEND_QUEUE_SIZE,
+                            const OscSendOverflow policy = OscSendOverflow::BLOCK,
+                            const bool with_thread = true) {
+            return OscClientManager<S>::getInstance().startSendQueue(queue_size, policy, with_thread);
+        }
+        void stopSendQueue() {
+            OscClientManager<S>::getInstance().stopSendQueue();
+        }
+        size_t flush(const size_t max_packets = 0) {
+            return OscClientManager<S>::getInstance().flush(max_packets);
+        }
+        OscSendQueueStats sendQueueStats() const {
+            return OscClientManager<S>::getInstance().sendQueueStats();
+        }
+#endif
+
+        template <typename IP, typename Addr, typename... Ts>
+        void send(const IP& ip, const uint16_t port, const Addr& addr, Ts&&... ts) {
 #if defined(ARDUINOOSC_ENABLE_WIFI) && (defined(ESP_PLATFORM) || defined(ARDUINO_ARCH_RP2040))
             if (this->isWiFiConnected() || this->isWiFiModeAP()) {
                 OscClientManager<S>::getInstance().send(ip, port, addr, std::forward<Ts>(ts)...);
@@ -141,14 +202,15 @@ namespace osc {
         void begin_bundle(const TimeTag &tt) {
             OscClientManager<S>::getInstance().begin_bundle(tt);
         }
-        template <typename... Ts>
-        void add_bundle(const String &addr, Ts&&... ts) {
+        template <typename Addr, typename... Ts>
+        void add_bundle(const Addr& addr, Ts&&... ts) {
             OscClientManager<S>::getInstance().add_bundle(addr, std::forward<Ts>(ts)...);
         }
         void end_bundle() {
             OscClientManager<S>::getInstance().end_bundle();
         }
-        void send_bundle(const String& ip, const uint16_t port) {
+        template <typename IP>
+        void send_bundle(const IP& ip, const uint16_t port) {
 #if defined(ARDUINOOSC_ENABLE_WIFI) && (defined(ESP_PLATFORM) || defined(ARDUINO_ARCH_RP2040))
             if (this->isWiFiConnected() || this->isWiFiModeAP()) {
                 OscClientManager<S>::getInstance().send_bundle(ip, port);
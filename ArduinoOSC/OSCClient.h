@@ -11,7 +11,13 @@
 
 #include "OscMessage.h"
 #include "OscEncoder.h"
+#include "OscSchema.h"
 #include "OscUdpMap.h"
+#include "OscSendQueue.h"
+#ifdef ARDUINOOSC_HAVE_THREAD
+#include <memory>
+#include <mutex>
+#endif
 
 namespace arduino {
 namespace osc {
@@ -23,12 +29,24 @@ namespace osc {
             struct Base {
                 uint32_t last_publish_us {0};
                 uint32_t interval_us {33333};  // 30 fps
+                // the time slot of the last publish in the clock of Manager::post()
+                uint64_t published_us {0};
+                bool published {false};
+
+                bool next() const { return (uint32_t)(micros() - last_publish_us) >= interval_us; }
+                void setFrameRate(float fps) { setIntervalUsec((uint32_t)(1000000.f / fps)); }
+                void setIntervalUsec(const uint32_t us) {
+                    interval_us = us;
+                    ++intervalChanges();
+                }
+                void setIntervalMsec(const float ms) { setIntervalUsec((uint32_t)(ms * 1000.f)); }
+                void setIntervalSec(const float sec) { setIntervalUsec((uint32_t)(sec * 1000.f * 1000.f)); }
 
-                bool next() const { return micros() >= (last_publish_us + interval_us); }
-                void setFrameRate(float fps) { interval_us = (uint32_t)(1000000.f / fps); }
-                void setIntervalUsec(const uint32_t us) { interval_us = us; }
-                void setIntervalMsec(const float ms) { interval_us = (uint32_t)(ms * 1000.f); }
-                void setIntervalSec(const float sec) { interval_us = (uint32_t)(sec * 1000.f * 1000.f); }
+                // counts the interval changes of all the elements, so that Manager::post() reschedules them
+                static uint32_t& intervalChanges() {
+                    static uint32_t n = 0;
+                    return n;
+                }
 
                 void init(Message& m, const String& addr) { m.init(addr); }
 
@@ -112,6 +130,11 @@ namespace osc {
             return ElementRef(new element::Tuple(std::move(t)));
         }
 
+        // the destination can be given as a dotted string or as a binary IPAddress
+        inline const char* udp_host(const String& ip) { return ip.c_str(); }
+        inline const char* udp_host(const char* ip) { return ip; }
+        inline const IPAddress& udp_host(const IPAddress& ip) { return ip; }
+
         struct Destination {
             String ip;
             uint16_t port;
@@ -149,55 +172,182 @@ namespace osc {
             }
         };
 
-        template <typename S>
-        class Client {
+        // the message and the encoder which a send (or a bundle) is built with
+        struct SendContext {
             Encoder writer;
             Message msg;
+        };
+
+        template <typename S>
+        class Client {
+            SendContext ctx;
             uint16_t local_port;
+            bool streaming_mode {false};
+#ifdef ARDUINOOSC_HAVE_THREAD
+            bool concurrent_mode {false};
+            UdpRef<S> concurrent_stream;  // resolved once, the udp map is not touched by the senders
+            std::unique_ptr<SendQueue<S>> send_queue;
+            bool async_mode {false};
+#endif
 
         public:
             Client(const uint16_t local_port = PORT_DISCARD)
             : local_port(local_port) {
+#ifdef ARDUINOOSC_HAVE_THREAD
+                // construct it first so that it outlives the client, whose send queue locks the udp at exit
+                UdpMapManager<S>::getInstance();
+#endif
             }
 
             void localPort(const uint16_t port) {
                 local_port = port;
+#ifdef ARDUINOOSC_HAVE_THREAD
+                if (concurrent_mode) concurrent_stream = UdpMapManager<S>::getInstance().getUdp(local_port);
+#endif
             }
             uint16_t localPort() const {
                 return UdpMapManager<S>::getInstance().getUdp(local_port)->localPort();
             }
 
-            template <typename... Rest>
-            void send(const String& ip, const uint16_t port, const String& addr, Rest&&... rest) {
-                msg.init(addr);
-                send(ip, port, msg, std::forward<Rest>(rest)...);
+            // write messages directly into the packet with StreamEncoder instead of encoding them
+            // into Message and Encoder first (bundles are always encoded by Encoder)
+            void streaming(const bool b) {
+                streaming_mode = b;
             }
-            template <typename First, typename... Rest>
-            void send(const String& ip, const uint16_t port, Message& m, First&& first, Rest&&... rest) {
+            bool streaming() const {
+                return streaming_mode;
+            }
+
+#ifdef ARDUINOOSC_HAVE_THREAD
+            // let multiple threads send at the same time
+            // each thread encodes into its own SendContext (also a bundle is built per thread),
+            // and only writing the encoded packet into the udp is serialized per udp
+            // set it before the threads start sending, and after the local port and the servers are set up
+            void concurrent(const bool b) {
+                concurrent_mode = b;
+                concurrent_stream = b ? UdpMapManager<S>::getInstance().getUdp(local_port) : UdpRef<S>();
+            }
+            bool concurrent() const {
+                return concurrent_mode;
+            }
+
+            // queue the encoded packets and return from send() right away
+            // they are sent in batches by the flusher thread, or by flush() if with_thread is false
+            // the messages are built per thread as in concurrent(), so multiple threads can send
+            // start and stop it while no other thread sends
+            bool startSendQueue(const size_t queue_size = ARDUINOOSC_SEND_QUEUE_SIZE,
+                                const SendOverflow policy = SendOverflow::BLOCK,
+                                const bool with_thread = true) {
+                if (async_mode) return false;
+                if (!send_queue) send_queue.reset(new SendQueue<S>());
+                if (!send_queue->start(UdpMapManager<S>::getInstance().getUdp(local_port), queue_size, policy, with_thread))
+                    return false;
+                async_mode = true;
+                return true;
+            }
+            // the queued packets are sent before it returns
+            void stopSendQueue() {
+                if (!async_mode) return;
+                async_mode = false;
+                send_queue->stop();
+            }
+            bool sendQueueRunning() const {
+                return async_mode;
+            }
+            // send up to max_packets queued packets (0 means all) in the calling thread
+            size_t flush(const size_t max_packets = 0) {
+                return async_mode ? send_queue->flush(max_packets) : 0;
+            }
+            SendQueueStats sendQueueStats() const {
+                return send_queue ? send_queue->stats() : SendQueueStats();
+            }
+#endif
+
+            template <typename IP, typename... Rest>
+            void send(const IP& ip, const uint16_t port, const String& addr, Rest&&... rest) {
+                send(ip, port, addr.c_str(), std::forward<Rest>(rest)...);
+            }
+            template <typename IP, typename... Rest>
+            void send(const IP& ip, const uint16_t port, const char* addr, Rest&&... rest) {
+                if (streaming_mode) {
+#ifdef ARDUINOOSC_HAVE_THREAD
+                    if (async_mode) {
+                        send_queue->push(ip, port, [&](SendPacket& p) { StreamEncoder<SendPacket>(p).encode(addr, rest...).flush(); });
+                        return;
+                    }
+#endif
+                    packet(ip, port, [&](S& stream) { StreamEncoder<S>(stream).encode(addr, rest...).flush(); });
+                    return;
+                }
+                Message& m = context().msg;
+                m.init(addr);
+                send(ip, port, m, std::forward<Rest>(rest)...);
+            }
+            template <typename IP, typename First, typename... Rest>
+            void send(const IP& ip, const uint16_t port, Message& m, First&& first, Rest&&... rest) {
                 m.push(first);
                 send(ip, port, m, std::forward<Rest>(rest)...);
             }
-            void send(const String& ip, const uint16_t port, Message& m) {
-                this->writer.init().encode(m);
+            // the schema message is written to the packet directly without Message and Encoder
+            template <typename IP, typename... As, typename... Vs>
+            void send(const IP& ip, const uint16_t port, const Schema<As...>& schema, const Vs&... vs) {
+#ifdef ARDUINOOSC_HAVE_THREAD
+                if (async_mode) {
+                    send_queue->push(ip, port, [&](SendPacket& p) { schema.write(p, vs...); });
+                    return;
+                }
+#endif
+                packet(ip, port, [&](S& stream) { schema.write(stream, vs...); });
+            }
+            template <typename IP>
+            void send(const IP& ip, const uint16_t port, Message& m) {
+                if (m.overflow()) {
+                    LOG_ERROR(F("message is not sent because the address is too long"));
+                    return;
+                }
+#ifdef ARDUINOOSC_HAVE_THREAD
+                // encoded into the slot of the queue directly
+                if (async_mode) {
+                    send_queue->push(ip, port, [&](SendPacket& p) { m.encodeTo((char*)p.reserve(m.encodedSize())); });
+                    return;
+                }
+#endif
+                if (streaming_mode) {
+                    packet(ip, port, [&](S& stream) { StreamEncoder<S>(stream).encode(m).flush(); });
+                    return;
+                }
+                context().writer.init().encode(m);
                 this->send(ip, port);
             }
-            void send(const String &ip, const uint16_t port)
+            template <typename IP>
+            void send(const IP& ip, const uint16_t port)
             {
-                auto stream = UdpMapManager<S>::getInstance().getUdp(local_port);
-                stream->beginPacket(ip.c_str(), port);
-                stream->write(this->writer.data(), this->writer.size());
-                stream->endPacket();
+                const Encoder& writer = context().writer;
+#ifdef ARDUINOOSC_HAVE_THREAD
+                if (async_mode) {
+                    send_queue->push(ip, port, [&](SendPacket& p) { p.write(writer.data(), writer.size()); });
+                    return;
+                }
+#endif
+                packet(ip, port, [&](S& stream) { stream.write(writer.data(), writer.size()); });
             }
 
 #ifndef ARDUINOOSC_DISABLE_BUNDLE
 
             void begin_bundle(const TimeTag &tt) {
-                this->writer.init().begin_bundle(tt);
+                context().writer.init().begin_bundle(tt);
             }
             template <typename... Rest>
             void add_bundle(const String& addr, Rest&&... rest) {
-                this->msg.init(addr);
-                this->add_bundle(this->msg, std::forward<Rest>(rest)...);
+                Message& m = context().msg;
+                m.init(addr);
+                this->add_bundle(m, std::forward<Rest>(rest)...);
+            }
+            template <typename... Rest>
+            void add_bundle(const char* addr, Rest&&... rest) {
+                Message& m = context().msg;
+                m.init(addr);
+                this->add_bundle(m, std::forward<Rest>(rest)...);
             }
             template <typename First, typename... Rest>
             void add_bundle(Message& m, First&& first, Rest&&... rest)
@@ -207,19 +357,144 @@ namespace osc {
             }
             void add_bundle(Message& m)
             {
-                this->writer.encode(m);
+                context().writer.encode(m);
             }
             void end_bundle()
             {
-                this->writer.end_bundle();
+                context().writer.end_bundle();
             }
 
 #endif // ARDUINOOSC_DISABLE_BUNDLE
 
-            void send(const Destination& dest, ElementRef elem) {
-                elem->init(msg, dest.addr);
-                elem->encodeTo(msg);
-                send(dest.ip, dest.port, msg);
+            void send(const Destination& dest, const ElementRef& elem) {
+                Message& m = context().msg;
+                elem->init(m, dest.addr);
+                elem->encodeTo(m);
+                send(dest.ip, dest.port, m);
+            }
+
+        private:
+            SendContext& context() {
+#ifdef ARDUINOOSC_HAVE_THREAD
+                if (concurrent_mode || async_mode) return thread_context();
+#endif
+                return ctx;
+            }
+
+#ifdef ARDUINOOSC_HAVE_THREAD
+            // shared by the clients of the same udp type in the thread
+            // only touched in concurrent or async mode, so other senders don't pay for the thread_local
+            static SendContext& thread_context() {
+                static thread_local SendContext thread_ctx;
+                return thread_ctx;
+            }
+#endif
+
+            // write a packet with w(S&) between beginPacket() and endPacket()
+            template <typename IP, typename W>
+            void packet(const IP& ip, const uint16_t port, W&& w) {
+#ifdef ARDUINOOSC_HAVE_THREAD
+                if (concurrent_mode) {
+                    std::lock_guard<std::mutex> lock(UdpMapManager<S>::getInstance().packetMutex(concurrent_stream.get()));
+                    write_packet(*concurrent_stream, ip, port, w);
+                    return;
+                }
+#endif
+                auto stream = UdpMapManager<S>::getInstance().getUdp(local_port);
+                write_packet(*stream, ip, port, w);
+            }
+            template <typename IP, typename W>
+            static void write_packet(S& stream, const IP& ip, const uint16_t port, W& w) {
+                stream.beginPacket(udp_host(ip), port);
+                w(stream);
+                stream.endPacket();
+            }
+        };
+
+        struct PublishEntry {
+            uint64_t due_us;
+            const Destination* dest;
+            const ElementRef* elem;
+        };
+
+        // published elements in a min-heap by their next deadline,
+        // so that post() touches only the elements which are due
+        // the deadlines are in 64-bit microseconds extended from micros(), which doesn't wrap around,
+        // and the heap refers to the entries of DestinationMap, so it's rebuilt when the map is changed
+        class PublishSchedule {
+            PublishHeap heap;
+            uint64_t now_us {0};
+            uint32_t last_micros {0};
+            uint32_t interval_changes {0};
+            bool dirty {false};
+
+        public:
+            // must be called when the DestinationMap is changed
+            void invalidate() { dirty = true; }
+
+            size_t size() const { return heap.size(); }
+
+            // the current time, post() must be called at least once in 71 minutes
+            uint64_t now() {
+                const uint32_t t = micros();
+                now_us += (uint32_t)(t - last_micros);
+                last_micros = t;
+                return now_us;
+            }
+
+            // call f(const Destination&, const ElementRef&) for each element which is due, earliest first
+            // each element is published at most once per call, and a missed slot is not caught up
+            template <typename F>
+            size_t post(const DestinationMap& dest_map, F&& f) {
+                if (dirty || (interval_changes != element::Base::intervalChanges())) rebuild(dest_map);
+                if (heap.empty()) return 0;
+                const uint64_t t = now();
+                size_t n = 0;
+                while (heap[0].due_us <= t) {
+                    PublishEntry& e = heap[0];
+                    element::Base& elem = **e.elem;
+                    elem.last_publish_us = (uint32_t)t;
+                    elem.published = true;
+                    elem.published_us = e.due_us;
+                    // keep the period if it's in time, otherwise start over from now
+                    if (elem.published_us + elem.interval_us <= t) elem.published_us = t;
+                    e.due_us = elem.published_us + (elem.interval_us ? elem.interval_us : 1);
+                    f(*e.dest, *e.elem);
+                    siftDown(0);
+                    ++n;
+                }
+                return n;
+            }
+
+        private:
+            void rebuild(const DestinationMap& dest_map) {
+                heap.clear();
+                for (auto& mp : dest_map) {
+                    if (!mp.second) continue;
+                    const element::Base& elem = *mp.second;
+                    // a new element is published at the next post()
+                    const uint64_t due = elem.published ? (elem.published_us + elem.interval_us) : 0;
+                    heap.push_back(PublishEntry {due, &mp.first, &mp.second});
+                }
+                for (size_t i = heap.size() / 2; i > 0; --i) siftDown(i - 1);
+                interval_changes = element::Base::intervalChanges();
+                dirty = false;
+            }
+
+            void siftDown(size_t i) {
+                const size_t n = heap.size();
+                while (true) {
+                    const size_t l = 2 * i + 1;
+                    const size_t r = l + 1;
+                    size_t m = i;
+                    if ((l < n) && (heap[l].due_us < heap[m].due_us)) m = l;
+                    if ((r < n) && (heap[r].due_us < heap[m].due_us)) m = r;
+                    if (m == i) break;
+                    const PublishEntry tmp = heap[i];
+                    heap[i] = heap[m];
+                    heap[m] = tmp;
+                    i = m;
+                }
             }
         };
 
@@ -231,6 +506,7 @@ namespace osc {
 
             Client<S> client;
             DestinationMap dest_map;
+            PublishSchedule schedule;
 
         public:
             static Manager<S>& getInstance() {
@@ -248,33 +524,58 @@ namespace osc {
             uint16_t localPort() const {
                 return client.localPort();
             }
+            void streaming(const bool b) {
+                client.streaming(b);
+            }
+            bool streaming() const {
+                return client.streaming();
+            }
+#ifdef ARDUINOOSC_HAVE_THREAD
+            void concurrent(const bool b) {
+                client.concurrent(b);
+            }
+            bool concurrent() const {
+                return client.concurrent();
+            }
+            bool startSendQueue(const size_t queue_size = ARDUINOOSC_SEND_QUEUE_SIZE,
+                                const SendOverflow policy = SendOverflow::BLOCK,
+                                const bool with_thread = true) {
+                return client.startSendQueue(queue_size, policy, with_thread);
+            }
+            void stopSendQueue() {
+                client.stopSendQueue();
+            }
+            size_t flush(const size_t max_packets = 0) {
+                return client.flush(max_packets);
+            }
+            SendQueueStats sendQueueStats() const {
+                return client.sendQueueStats();
+            }
+#endif
 
-            template <typename... Ts>
-            void send(const String& ip, const uint16_t port, const String& addr, Ts&&... ts) {
+            template <typename IP, typename Addr, typename... Ts>
+            void send(const IP& ip, const uint16_t port, const Addr& addr, Ts&&... ts) {
                 client.send(ip, port, addr, std::forward<Ts>(ts)...);
             }
 
             void begin_bundle(const TimeTag &tt) {
                 client.begin_bundle(tt);
             }
-            template <typename... Ts>
-            void add_bundle(const String& addr, Ts&&... ts) {
+            template <typename Addr, typename... Ts>
+            void add_bundle(const Addr& addr, Ts&&... ts) {
                 client.add_bundle(addr, std::forward<Ts>(ts)...);
             }
             void end_bundle() {
                 client.end_bundle();
             }
-            void send_bundle(const String& ip, const uint16_t port) {
+            template <typename IP>
+            void send_bundle(const IP& ip, const uint16_t port) {
                 client.send(ip, port);
             }
 
+            // publish the elements whose interval has passed
             void post() {
-                for (auto& mp : dest_map) {
-                    if (mp.second->next()) {
-                        mp.second->last_publish_us = micros();
-                        client.send(mp.first, mp.second);
-                    }
-                }
+                schedule.post(dest_map, [&](const Destination& dest, const ElementRef& elem) { client.send(dest, elem); });
             }
 
             ElementRef publish(const String& ip, const uint16_t port, const String& addr, const char* const value) {
@@ -312,13 +613,15 @@ namespace osc {
 
             ElementRef getPublishElementRef(const String& ip, const uint16_t port, const String& addr) {
                 Destination dest {ip, port, addr};
-                return dest_map[dest];
+                auto it = dest_map.find(dest);
+                return (it != dest_map.end()) ? it->second : ElementRef();
             }
 
         private:
             ElementRef publish_impl(const String& ip, const uint16_t port, const String& addr, ElementRef ref) {
                 Destination dest {ip, port, addr};
                 dest_map.insert(std::make_pair(dest, ref));
+                schedule.invalidate();
                 return ref;
             }
         };
@@ -12,7 +12,13 @@
 
 #include "OscMessage.h"
 #include "OscDecoder.h"
+#include "OscSchema.h"
+#include "OscElementPool.h"
+#include "OscScheduler.h"
+#include "OscDispatch.h"
 #include "OscUdpMap.h"
+#include "OscReceiveThread.h"
+#include "OscDispatchExecutor.h"
 
 namespace arduino {
 namespace osc {
@@ -21,99 +27,236 @@ namespace osc {
         using namespace message;
 
         namespace element {
-            struct Base {
-                virtual ~Base() {}
-                virtual void decodeFrom(Message& m, const size_t offset = 0) = 0;
-            };
-
             template <typename T>
             inline void decode_from_msg(Message& m, const size_t i, T& t) {
                 t = m.arg<T>(i);
             }
 
-            inline void decode_from_msg(Message& m, const TupleRef& ts) {
-                for (size_t idx = 0; idx < ts.size(); ++idx)
-                    ts[idx]->decodeFrom(m, idx);
+            // strings and blobs are assigned in place to reuse their buffers
+            inline void decode_from_msg(Message& m, const size_t i, String& s) {
+                s = m.getArgAsCStr(i);
+            }
+            inline void decode_from_msg(Message& m, const size_t i, Blob& b) {
+                const BlobView v = m.getArgAsBlobView(i);
+                b.assign((const char*)v.begin(), (const char*)v.end());
+            }
+
+#if ARX_HAVE_LIBSTDCPLUSPLUS >= 201103L  // Have libstdc++11
+            // all arguments from i are decoded into the vector in one pass
+            inline void decode_from_msg(Message& m, const size_t i, std::vector<float>& v) {
+                v.resize((i < m.size()) ? (m.size() - i) : 0);
+                v.resize(m.copyFloats(v.data(), i, v.size()));
             }
+            inline void decode_from_msg(Message& m, const size_t i, std::vector<int32_t>& v) {
+                v.resize((i < m.size()) ? (m.size() - i) : 0);
+                v.resize(m.copyInt32s(v.data(), i, v.size()));
+            }
+#endif
+
+            namespace detail {
+                template <typename... Ts, size_t... Indices>
+                inline void read_to_tuple(
+                    std::index_sequence<Indices...>&&,
+                    Message& m,
+                    std::tuple<Ts...>& t) {
+                    using expand = int[];
+                    (void)expand {0, (decode_from_msg(m, Indices, std::get<Indices>(t)), 0)...};
+                }
+
+                template <typename... Ts>
+                inline void read_to_tuple(Message& m, std::tuple<Ts...>& t) {
+                    read_to_tuple(std::index_sequence_for<Ts...>(), m, t);
+                }
+
+                // expected type tag of an argument
+                // bool accepts both 'T' and 'F', and '\0' is not checked (e.g. a vector takes all the rest)
+                // long and 64-bit integers accept both 'i' and 'h', so that the same callback works on 32-bit and 64-bit targets
+                template <typename T, typename = void>
+                struct type_tag {
+                    static constexpr char value = '\0';
+                };
+                template <typename T>
+                struct is_wide_int {
+                    static constexpr bool value = std::is_integral<T>::value
+                        && ((sizeof(T) == 8) || std::is_same<T, long>::value || std::is_same<T, unsigned long>::value);
+                };
+                template <typename T>
+                struct type_tag<T, std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value && !is_wide_int<T>::value>> {
+                    static constexpr char value = TYPE_TAG_INT32;
+                };
+                template <typename T>
+                struct type_tag<T, std::enable_if_t<is_wide_int<T>::value>> {
+                    static constexpr char value = TYPE_TAG_INT64;
+                };
+                template <char C>
+                struct type_tag_is {
+                    static constexpr char value = C;
+                };
+                template <>
+                struct type_tag<bool> : type_tag_is<TYPE_TAG_TRUE> {};
+                template <>
+                struct type_tag<float> : type_tag_is<TYPE_TAG_FLOAT> {};
+                template <>
+                struct type_tag<double> : type_tag_is<TYPE_TAG_DOUBLE> {};
+                template <>
+                struct type_tag<String> : type_tag_is<TYPE_TAG_STRING> {};
+                template <>
+                struct type_tag<const char*> : type_tag_is<TYPE_TAG_STRING> {};
+                template <>
+                struct type_tag<StringView> : type_tag_is<TYPE_TAG_STRING> {};
+                template <>
+                struct type_tag<Blob> : type_tag_is<TYPE_TAG_BLOB> {};
+                template <>
+                struct type_tag<BlobView> : type_tag_is<TYPE_TAG_BLOB> {};
+#ifdef ARDUINOOSC_HAVE_STRING_VIEW
+                template <>
+                struct type_tag<std::string_view> : type_tag_is<TYPE_TAG_STRING> {};
+#endif
+#ifdef ARDUINOOSC_HAVE_SPAN
+                template <>
+                struct type_tag<std::span<const uint8_t>> : type_tag_is<TYPE_TAG_BLOB> {};
+#endif
+
+                template <char... Cs>
+                struct exact_tags : std::true_type {};
+                template <char C, char... Cs>
+                struct exact_tags<C, Cs...>
+                : std::integral_constant<bool, (C != '\0') && (C != TYPE_TAG_TRUE) && (C != TYPE_TAG_INT64) && exact_tags<Cs...>::value> {};
+
+                // type tags of the arguments, built at compile time
+                template <typename... Ts>
+                struct TypeTags {
+                    static constexpr char tags[sizeof...(Ts) + 1] = {type_tag<std::remove_cvref_t<Ts>>::value..., '\0'};
+                    // if all tags are fixed, they are compared with one memcmp
+                    static constexpr bool exact = exact_tags<type_tag<std::remove_cvref_t<Ts>>::value...>::value;
+
+                    static bool match(const Message& m) {
+                        if (m.size() != sizeof...(Ts)) return false;
+                        const char* t = m.typeTagsCStr();
+                        if (exact) return memcmp(t, tags, sizeof...(Ts)) == 0;
+                        for (size_t i = 0; i < sizeof...(Ts); ++i) {
+                            if (tags[i] == '\0') continue;
+                            if (tags[i] == TYPE_TAG_TRUE) {
+                                if ((t[i] != TYPE_TAG_TRUE) && (t[i] != TYPE_TAG_FALSE)) return false;
+                            } else if (tags[i] == TYPE_TAG_INT64) {
+                                if ((t[i] != TYPE_TAG_INT64) && (t[i] != TYPE_TAG_INT32)) return false;
+                            } else if (t[i] != tags[i]) {
+                                return false;
+                            }
+                        }
+                        return true;
+                    }
+                    static uint32_t hash() { return hashAddress(tags); }
+                };
+                template <typename... Ts>
+                constexpr char TypeTags<Ts...>::tags[sizeof...(Ts) + 1];
+
+                // callback which takes the Message as it is
+                struct AnyTags {
+                    static constexpr bool exact = false;
+                    static bool match(const Message&) { return true; }
+                    static uint32_t hash() { return 0; }
+                };
+
+                // the arguments of a callable, as a function pointer type
+                template <typename F>
+                struct signature : signature<decltype(&F::operator())> {};
+                template <typename C, typename R, typename... Ts>
+                struct signature<R (C::*)(Ts...)> {
+                    using pointer = R (*)(Ts...);
+                };
+                template <typename C, typename R, typename... Ts>
+                struct signature<R (C::*)(Ts...) const> {
+                    using pointer = R (*)(Ts...);
+                };
+                template <typename R, typename... Ts>
+                struct signature<R(Ts...)> {
+                    using pointer = R (*)(Ts...);
+                };
+                template <typename R, typename... Ts>
+                struct signature<R (*)(Ts...)> {
+                    using pointer = R (*)(Ts...);
+                };
+            };  // namespace detail
 
             // single value
+            // the type tag is checked like Values, except for a vector which takes all the arguments
             template <typename T>
             class Value : public Base {
                 T& t;
 
             public:
+                using Tags = detail::TypeTags<T>;
+
                 Value(T& t)
                 : t(t) {}
                 virtual ~Value() {}
                 virtual void decodeFrom(Message& m, const size_t offset = 0) override {
-                    decode_from_msg(m, offset, t);
+                    if ((Tags::tags[0] != '\0') && !Tags::match(m)) {
+                        LOG_ERROR(F("type tags mismatch: msg"), m.typeTagsCStr(), F("/ subscribe"), Tags::tags);
+                    } else {
+                        decode_from_msg(m, offset, t);
+                    }
                 }
             };
 
-            // mutiple values
-            class Tuple : public Base {
-                TupleRef t;
+            // mutiple values, kept as one tuple of references
+            template <typename... Ts>
+            class Values : public Base {
+                std::tuple<Ts&...> t;
 
             public:
-                Tuple(TupleRef&& t)
-                : t(std::move(t)) {}
-                virtual ~Tuple() {}
+                Values(Ts&... ts)
+                : t(ts...) {}
+                virtual ~Values() {}
                 virtual void decodeFrom(Message& m, const size_t offset = 0) override {
                     (void)offset;
-                    if (m.size() == t.size()) {
-                        decode_from_msg(m, t);
+                    if (m.size() != sizeof...(Ts)) {
+                        LOG_ERROR("arg size mismatch: msg", m.size(), "/ subscribe", sizeof...(Ts));
+                    } else if (!detail::TypeTags<Ts...>::match(m)) {
+                        LOG_ERROR(F("type tags mismatch: msg"), m.typeTagsCStr(), F("/ subscribe"), detail::TypeTags<Ts...>::tags);
                     } else {
-                        LOG_ERROR("arg size mismatch: msg", m.size(), "/ subscribe", t.size());
+                        detail::read_to_tuple(m, t);
                     }
                 }
             };
 
-            namespace detail {
-                template <typename... Ts, size_t... Indices>
-                inline void read_to_tuple(
-                    std::index_sequence<Indices...>&&,
-                    Message& m,
-                    std::tuple<Ts...>& t) {
-                    size_t o {0};
-                    dummy_vector_t {(decode_from_msg(m, o, std::get<Indices>(t)), ++o)...};
-                }
-
-                template <typename... Ts>
-                inline void read_to_tuple(Message& m, std::tuple<Ts...>& t) {
-                    read_to_tuple(std::index_sequence_for<Ts...>(), m, t);
-                }
-            };  // namespace detail
-
             // callback with user defined arguments
-            template <typename R, typename... Ts>
+            // the callable is stored as it is (not as std::function), in the slot of the element
+            // the type tags are checked before decoding, and the arguments are decoded into the same tuple every time
+            template <typename F, typename R, typename... Ts>
             class Function : public Base {
-                using Func = std::function<R(Ts...)>;
-                Func func;
+                F func;
+                std::tuple<std::remove_cvref_t<Ts>...> values;
 
             public:
-                Function(Func func)
+                using Tags = detail::TypeTags<Ts...>;
+
+                Function(const F& func)
                 : func(func) {};
                 virtual ~Function() {}
                 virtual void decodeFrom(Message& m, size_t offset = 0) override {
-                    if (m.size() == sizeof...(Ts)) {
-                        std::tuple<std::remove_cvref_t<Ts>...> t;
-                        detail::read_to_tuple(m, t);
-                        std::apply(func, t);
-                        (void)offset;
-                    } else {
+                    (void)offset;
+                    if (m.size() != sizeof...(Ts)) {
                         LOG_ERROR("arg size mismatch: msg", m.size(), "/ func", sizeof...(Ts));
+                    } else if (!Tags::match(m)) {
+                        LOG_ERROR(F("type tags mismatch: msg"), m.typeTagsCStr(), F("/ func"), Tags::tags);
+                    } else {
+                        detail::read_to_tuple(m, values);
+                        std::apply(func, values);
                     }
                 }
             };
 
             // callback with Message&
-            template <typename R>
-            class Function<R, Message&> : public Base {
-                using Func = std::function<R(Message&)>;
-                Func func;
+            template <typename F, typename R>
+            class Function<F, R, Message&> : public Base {
+                F func;
 
             public:
-                Function(Func func)
+                using Tags = detail::AnyTags;
+
+                Function(const F& func)
                 : func(func) {};
                 virtual ~Function() {}
                 virtual void decodeFrom(Message& m, size_t offset = 0) override {
@@ -123,13 +266,14 @@ namespace osc {
             };
 
             // callback with const Message&
-            template <typename R>
-            class Function<R, const Message&> : public Base {
-                using Func = std::function<R(const Message&)>;
-                Func func;
+            template <typename F, typename R>
+            class Function<F, R, const Message&> : public Base {
+                F func;
 
             public:
-                Function(Func func)
+                using Tags = detail::AnyTags;
+
+                Function(const F& func)
                 : func(func) {};
                 virtual ~Function() {}
                 virtual void decodeFrom(Message& m, size_t offset = 0) override {
@@ -138,8 +282,92 @@ namespace osc {
                 }
             };
 
+            // callbacks for the same address with different arguments
+            // the one whose type tags match the message is called (the first one if some match)
+            // candidates are picked by the hash of the type tags, and confirmed by TypeTags::match()
+            template <size_t N>
+            class Overloads : public Base {
+                struct Entry {
+                    uint32_t hash;
+                    bool exact;  // if false, only match() is used (e.g. bool or Message& arguments)
+                    bool (*match)(const Message&);
+                    Ref elem;
+                };
+                Entry entries[N];
+
+            public:
+                template <typename... Fs>
+                Overloads(Fs... fs)
+                : entries {entry(fs)...} {}
+                virtual ~Overloads() {}
+                virtual void decodeFrom(Message& m, const size_t offset = 0) override {
+                    const uint32_t h = hashAddress(m.typeTagsCStr());
+                    for (auto& e : entries) {
+                        if ((!e.exact || (e.hash == h)) && e.match(m)) {
+                            e.elem->decodeFrom(m, offset);
+                            return;
+                        }
+                    }
+                    LOG_ERROR(F("no overload for the type tags:"), m.typeTagsCStr());
+                }
+
+            private:
+                template <typename F>
+                static Entry entry(const F& f) {
+                    return entry(f, typename detail::signature<F>::pointer());
+                }
+                template <typename F, typename R, typename... Ts>
+                static Entry entry(const F& f, R (*)(Ts...)) {
+                    using Func = Function<F, R, Ts...>;
+                    using Tags = typename Func::Tags;
+                    return Entry {Tags::hash(), Tags::exact, &Tags::match, Ref(new Func(f))};
+                }
+            };
+
+            // callback with the values decoded by the schema
+            template <typename F, typename... Ts>
+            class SchemaFunction : public Base {
+                F func;
+                std::tuple<Ts...> values;
+
+            public:
+                SchemaFunction(const F& func)
+                : func(func) {}
+                virtual ~SchemaFunction() {}
+                virtual void decodeFrom(Message& m, const size_t offset = 0) override {
+                    (void)offset;
+                    if (Schema<Ts...>::decode(m, values)) std::apply(func, values);
+                }
+            };
+
+            // values bound to the schema (e.g. members of a struct)
+            template <typename... Ts>
+            class SchemaValues : public Base {
+                std::tuple<Ts&...> values;
+
+            public:
+                SchemaValues(Ts&... ts)
+                : values(ts...) {}
+                virtual ~SchemaValues() {}
+                virtual void decodeFrom(Message& m, const size_t offset = 0) override {
+                    (void)offset;
+                    Schema<Ts...>::decode(m, values);
+                }
+            };
+
         }  // namespace element
 
+        template <typename... Ts, typename F>
+        inline auto make_element_ref(const Schema<Ts...>&, F&& func)
+            -> std::enable_if_t<arx::is_callable<std::decay_t<F>>::value, ElementRef> {
+            return ElementRef(new element::SchemaFunction<std::decay_t<F>, Ts...>(std::forward<F>(func)));
+        }
+
+        template <typename... Ts>
+        inline ElementRef make_element_ref(const Schema<Ts...>&, Ts&... ts) {
+            return ElementRef(new element::SchemaValues<Ts...>(ts...));
+        }
+
         // one (or last) argument
         template <typename T>
         inline auto make_element_ref(T& value)
@@ -147,46 +375,63 @@ namespace osc {
             return ElementRef(new element::Value<T>(value));
         }
 
-        // multiple parameters helper
-        inline ElementRef make_element_ref(ElementTupleRef&& t) {
-            return ElementRef(new element::Tuple(std::move(t)));
-        }
-
+        // multiple parameters
         template <typename T, typename... Ts>
-        inline auto make_element_ref(T&& t, Ts&&... ts)
-            -> std::enable_if_t<!arx::is_callable<T>::value, ElementRef> {
-            ElementTupleRef v {
-                make_element_ref(std::forward<T>(t)),
-                make_element_ref(std::forward<Ts>(ts))...};
-            return make_element_ref(std::move(v));
+        inline auto make_element_ref(T& t, Ts&... ts)
+            -> std::enable_if_t<!arx::is_callable<T>::value && (sizeof...(Ts) > 0), ElementRef> {
+            return ElementRef(new element::Values<T, Ts...>(t, ts...));
         }
 
         // callbacks impl
-        template <typename R, typename... Ts>
-        inline ElementRef make_element_ref(std::function<R(Ts...)> func) {
-            return ElementRef(new element::Function<R, Ts...>(func));
+        template <typename F, typename R, typename... Ts>
+        inline ElementRef make_function_ref(const F& func, R (*)(Ts...)) {
+            return ElementRef(new element::Function<F, R, Ts...>(func));
         }
 
         // functor i/f
         template <typename F>
         inline auto make_element_ref(F&& value)
             -> std::enable_if_t<arx::is_callable<F>::value, ElementRef> {
-            return make_element_ref(arx::function_traits<F>::cast(value));
+            using Func = std::decay_t<F>;
+            return make_function_ref<Func>(value, typename element::detail::signature<Func>::pointer());
         }
 
         // function ptr i/f
         template <typename F>
         inline auto make_element_ref(F* value)
             -> std::enable_if_t<arx::is_callable<F>::value, ElementRef> {
-            return make_element_ref(arx::function_traits<F>::cast(value));
+            return make_function_ref<F*>(value, typename element::detail::signature<F>::pointer());
+        }
+
+        // overloaded callbacks, chosen by the type tags of the message
+        template <typename F, typename G, typename... Fs>
+        inline auto make_element_ref(F&& f, G&& g, Fs&&... fs)
+            -> std::enable_if_t<arx::is_callable<std::decay_t<F>>::value && arx::is_callable<std::decay_t<G>>::value, ElementRef> {
+            return ElementRef(new element::Overloads<2 + sizeof...(Fs)>(f, g, fs...));
         }
 
         template <typename S>
         class Server {
-            Decoder decoder;
+            BundleWalker walker;
+            Message msg;  // reused for every message, bundles are dispatched one by one
             CallbackMap callbacks;
+            DispatchIndex index;
+            DispatchCache cache;
+            bool index_dirty {false};
+            bool message_patterns {false};
             const uint16_t port;
             OscMessage* msg_ptr {nullptr};
+            PacketBuffer packet_buf;  // reused for every packet, grows up to the largest one
+            size_t packet_size {0};
+            size_t max_packet_size {ARDUINOOSC_MAX_RECV_PACKET_SIZE};
+#ifndef ARDUINOOSC_DISABLE_BUNDLE
+            Scheduler sched;
+#endif
+#ifdef ARDUINOOSC_HAVE_THREAD
+            std::unique_ptr<ReceiveThread<S>> recv_thread;
+            bool recv_held {false};  // the front of the queue is the last dispatched message
+            DispatchExecutor* executor {nullptr};  // owned by Manager
+#endif
 
         public:
             explicit Server(const uint16_t port)
@@ -195,19 +440,35 @@ namespace osc {
                     LOG_ERROR(F("Port #9 is not valid. Please change the server port."));
                     delay(1000);
                 }
+                cache.resize(ARDUINOOSC_DISPATCH_CACHE_SIZE);
             }
             Server() {}
+#ifdef ARDUINOOSC_HAVE_THREAD
+            ~Server() { stopReceiveThread(); }
+#endif
 
             template <typename... Ts>
             void subscribe(const String& addr, Ts&&... ts) {
                 ElementRef ref = make_element_ref(std::forward<Ts>(ts)...);
                 callbacks.insert({addr, ref});
+                index_dirty = true;
+            }
+
+            template <typename... As, typename... Ts>
+            void subscribe(const Schema<As...>& schema, Ts&&... ts) {
+                ElementRef ref = make_element_ref(schema, std::forward<Ts>(ts)...);
+                callbacks.insert({String(schema.address()), ref});
+                index_dirty = true;
             }
 
             bool unsubscribe(const String& addr) {
                 auto it = callbacks.find(addr);
                 if (it != callbacks.end()) {
+#ifdef ARDUINOOSC_HAVE_THREAD
+                    if (executor && !executor->wait()) return false;
+#endif
                     callbacks.erase(it);
+                    index_dirty = true;
                     return true;
                 }
                 return false;
@@ -215,40 +476,203 @@ namespace osc {
 
             bool unsubscribeAll() {
                 if (!callbacks.empty()) {
+#ifdef ARDUINOOSC_HAVE_THREAD
+                    if (executor && !executor->wait()) return false;
+#endif
                     callbacks.clear();
+                    index_dirty = true;
                     return true;
                 }
                 return false;
             }
 
+            // cache the callbacks of up to n (rounded down to a power of two) recent addresses
+            // 0 disables the cache (default: ARDUINOOSC_DISPATCH_CACHE_SIZE)
+            void dispatchCache(const size_t n) { cache.resize(n); }
+            const DispatchCache& dispatchCache() const { return cache; }
+            DispatchCache& dispatchCache() { return cache; }
+
+            // OSC 1.0 dispatching, where the address of a received message can be a pattern (e.g. "/ch/*/mute")
+            // which is expanded over the plain subscribed addresses (disabled by default)
+            void messagePatterns(const bool b) {
+                message_patterns = b;
+                index_dirty = true;
+            }
+            bool messagePatterns() const { return message_patterns; }
+
+#ifndef ARDUINOOSC_DISABLE_BUNDLE
+            // messages in bundles with a future time tag are held until their time
+            // if a clock is given to the scheduler (disabled by default)
+            Scheduler& scheduler() { return sched; }
+            const Scheduler& scheduler() const { return sched; }
+#endif
+
+#ifdef ARDUINOOSC_HAVE_THREAD
+            // read and decode the packets in a background thread, and queue up to queue_size messages
+            // parse() then dispatches the queued messages instead of reading the udp
+            // core >= 0 pins the thread to the core (ESP32 and Linux)
+            bool startReceiveThread(const size_t queue_size = ARDUINOOSC_RECEIVE_QUEUE_SIZE, const int core = -1) {
+                if (!recv_thread) recv_thread.reset(new ReceiveThread<S>());
+                msg_ptr = nullptr;
+                recv_held = false;
+                return recv_thread->start(UdpMapManager<S>::getInstance().getUdp(port), queue_size, max_packet_size, core);
+            }
+
+            // the messages left in the queue are discarded
+            void stopReceiveThread() {
+                if (!recv_thread) return;
+                recv_thread->stop();
+                msg_ptr = nullptr;
+                recv_held = false;
+            }
+
+            bool receiveThreadRunning() const { return recv_thread && recv_thread->isRunning(); }
+            ReceiveStats receiveStats() const { return recv_thread ? recv_thread->stats() : ReceiveStats(); }
+
+            // run the callbacks in the worker threads of the executor (nullptr: in parse())
+            // usually set by Manager::dispatchWorkers()
+            void dispatchExecutor(DispatchExecutor* e) {
+                if (executor && !executor->wait()) return;
+                executor = e;
+            }
+            DispatchExecutor* dispatchExecutor() const { return executor; }
+
+            // messages to the subscription may be handled by any worker out of order
+            // returns false if the address is not subscribed
+            bool unordered(const String& addr, const bool b = true) {
+                auto it = callbacks.find(addr);
+                if (it == callbacks.end()) return false;
+                if (executor && !executor->wait()) return false;
+                it->second->unordered(b);
+                return true;
+            }
+#endif
+
             bool parse() {
+#ifndef ARDUINOOSC_DISABLE_BUNDLE
+                sched.dispatch([&](Message& m) { dispatch(m); });
+#endif
+#ifdef ARDUINOOSC_HAVE_THREAD
+                if (receiveThreadRunning()) return dispatchQueue(SIZE_MAX, 0) > 0;
+#endif
+                return receive() && (msg_ptr != nullptr);
+            }
+
+            // read packets until no packet is left or the budget runs out
+            // max_micros = 0 means no time limit, returns the number of handled packets
+            // (or messages, if the receive thread is running)
+            size_t parse(const size_t max_packets, const uint32_t max_micros = 0) {
+#ifndef ARDUINOOSC_DISABLE_BUNDLE
+                sched.dispatch([&](Message& m) { dispatch(m); });
+#endif
+#ifdef ARDUINOOSC_HAVE_THREAD
+                if (receiveThreadRunning()) return dispatchQueue(max_packets, max_micros);
+#endif
+                const uint32_t begin_us = micros();
+                size_t n = 0;
+                while ((n < max_packets) && receive()) {
+                    ++n;
+                    if (max_micros && ((uint32_t)(micros() - begin_us) >= max_micros)) break;
+                }
+                return n;
+            }
+
+            const OscMessage* message() const { return msg_ptr; }
+
+            // the last received packet, valid until the next parse()
+            // e.g. to decode it again with OscViewDecoder without copying
+            const uint8_t* packet() const { return packet_size ? &packet_buf.front() : nullptr; }
+            size_t packetSize() const { return packet_size; }
+
+            // larger packets are discarded (default: ARDUINOOSC_MAX_RECV_PACKET_SIZE)
+            void maxPacketSize(const size_t sz) {
+                max_packet_size = (sz < ARDUINOOSC_MAX_RECV_PACKET_SIZE) ? sz : ARDUINOOSC_MAX_RECV_PACKET_SIZE;
+            }
+            size_t maxPacketSize() const { return max_packet_size; }
+
+        private:
+#ifdef ARDUINOOSC_HAVE_THREAD
+            // dispatch the messages queued by the receive thread
+            // the last one is kept in the queue until the next call, so that message() stays valid
+            size_t dispatchQueue(const size_t max_msgs, const uint32_t max_micros) {
+                MessageRing& q = recv_thread->queue();
+                const uint32_t begin_us = micros();
+                size_t n = 0;
+                while (n < max_msgs) {
+                    if (recv_held) {
+                        if ((n > 0) && (q.size() < 2)) break;  // keep the last dispatched one
+                        q.pop();
+                        recv_held = false;
+                        msg_ptr = nullptr;
+                    }
+                    Message* m = q.front();
+                    if (!m) break;
+                    ++n;
+                    msg_ptr = m;
+                    recv_held = true;
+#ifndef ARDUINOOSC_DISABLE_BUNDLE
+                    if (!sched.take(*m))
+#endif
+                        dispatch(*m);
+                    if (max_micros && ((uint32_t)(micros() - begin_us) >= max_micros)) break;
+                }
+                return n;
+            }
+#endif
+
+            // returns false if there was no packet
+            bool receive() {
                 auto stream = UdpMapManager<S>::getInstance().getUdp(port);
                 const size_t size = stream->parsePacket();
                 if (size == 0) return false;
 
-                uint8_t data[size];
-                stream->read(data, size);
-
-                decoder.init(data, size);
-                while (Message* msg = decoder.decode()) {
-                    if (msg->available()) {
-                        msg->remoteIP(stream->S::remoteIP());
-                        msg->remotePort((uint16_t)stream->S::remotePort());
-                        for (auto& c : this->callbacks) {
-                            if (msg->match(c.first)) {
-                                c.second->decodeFrom(*msg);
-                            }
-                        }
-                        msg_ptr = msg;
+                msg_ptr = nullptr;
+                packet_size = 0;
+                if (size > max_packet_size) {
+                    // the rest of the packet is discarded by the next parsePacket()
+                    LOG_ERROR(F("packet size overflow:"), size, F("must be <="), max_packet_size);
+                    return true;
+                }
+                if (packet_buf.size() < size) packet_buf.resize(size);
+                packet_size = stream->read(&packet_buf.front(), size);
+                if (packet_size > size) packet_size = 0;  // read() failed (-1)
+
+                walker.init(&packet_buf.front(), packet_size);
+                const char* beg;
+                size_t sz;
+                TimeTag tt;
+                while (walker.next(beg, sz, tt)) {
+                    msg.init(beg, sz, tt);
+                    if (msg.available()) {
+                        msg.remoteIP(stream->S::remoteIP());
+                        msg.remotePort((uint16_t)stream->S::remotePort());
+#ifndef ARDUINOOSC_DISABLE_BUNDLE
+                        if (!sched.take(msg))
+#endif
+                            dispatch(msg);
+                        msg_ptr = &msg;
                     } else {
                         LOG_ERROR(F("osc message parsing failed"));
                         msg_ptr = nullptr;
                     }
                 }
-                return msg_ptr != nullptr;
+                return true;
             }
 
-            const OscMessage* message() const { return msg_ptr; }
+            void dispatch(Message& m) {
+                if (index_dirty) {
+                    index.build(callbacks, message_patterns);
+                    cache.invalidate();
+                    index_dirty = false;
+                }
+#ifdef ARDUINOOSC_HAVE_THREAD
+                if (executor) {
+                    cache.lookup(index, m.addressCStr(), [&](element::Base* elem) { executor->submit(elem, m); });
+                    return;
+                }
+#endif
+                cache.lookup(index, m.addressCStr(), [&](element::Base* elem) { elem->decodeFrom(m); });
+            }
         };
 
         template <typename S>
@@ -258,6 +682,15 @@ namespace osc {
             Manager& operator=(const Manager&) = delete;
 
             ServerMap<S> server_map;
+            size_t cache_size {ARDUINOOSC_DISPATCH_CACHE_SIZE};
+            bool message_patterns {false};
+#ifdef ARDUINOOSC_HAVE_THREAD
+            DispatchExecutor executor;  // stopped before the servers are destroyed
+#endif
+#ifndef ARDUINOOSC_DISABLE_BUNDLE
+            Scheduler::Clock sched_clock {nullptr};
+            LatePolicy late_policy {LatePolicy::RUN_NOW};
+#endif
 
         public:
             static Manager& getInstance() {
@@ -270,13 +703,62 @@ namespace osc {
             }
 
             Server<S>& getServer(const uint16_t port) {
-                if (server_map.find(port) == server_map.end())
+                if (server_map.find(port) == server_map.end()) {
                     server_map.insert(std::make_pair(port, ServerRef<S>(new Server<S>(port))));
+                    server_map[port]->dispatchCache(cache_size);
+                    server_map[port]->messagePatterns(message_patterns);
+#ifdef ARDUINOOSC_HAVE_THREAD
+                    server_map[port]->dispatchExecutor(executor.isRunning() ? &executor : nullptr);
+#endif
+#ifndef ARDUINOOSC_DISABLE_BUNDLE
+                    server_map[port]->scheduler().clock(sched_clock);
+                    server_map[port]->scheduler().latePolicy(late_policy);
+#endif
+                }
                 return *(server_map[port].get());
             }
 
-            template <typename... Ts>
-            void subscribe(const uint16_t port, const String& addr, Ts&&... ts) {
+            // set the dispatch cache size of all servers (including the ones subscribed later)
+            void dispatchCache(const size_t n) {
+                cache_size = n;
+                for (auto& m : server_map) m.second->dispatchCache(n);
+            }
+
+#ifdef ARDUINOOSC_HAVE_THREAD
+            // run the callbacks of all servers (including the ones subscribed later) in n worker threads
+            // 0 stops the workers, and the callbacks run in parse() again
+            bool dispatchWorkers(const size_t n, const size_t queue_size = ARDUINOOSC_DISPATCH_QUEUE_SIZE) {
+                for (auto& m : server_map) m.second->dispatchExecutor(nullptr);
+                executor.stop();
+                if (n == 0) return true;
+                if (!executor.start(n, queue_size)) return false;
+                for (auto& m : server_map) m.second->dispatchExecutor(&executor);
+                return true;
+            }
+            DispatchExecutor& dispatchExecutor() { return executor; }
+#endif
+
+            // enable message patterns of all servers (including the ones subscribed later)
+            void messagePatterns(const bool b) {
+                message_patterns = b;
+                for (auto& m : server_map) m.second->messagePatterns(b);
+            }
+
+#ifndef ARDUINOOSC_DISABLE_BUNDLE
+            // enable the bundle scheduler of all servers (including the ones subscribed later)
+            // the clock returns the current time as an NTP time tag, nullptr disables the scheduler
+            void scheduler(const Scheduler::Clock clock, const LatePolicy policy = LatePolicy::RUN_NOW) {
+                sched_clock = clock;
+                late_policy = policy;
+                for (auto& m : server_map) {
+                    m.second->scheduler().clock(clock);
+                    m.second->scheduler().latePolicy(policy);
+                }
+            }
+#endif
+
+            template <typename Addr, typename... Ts>
+            void subscribe(const uint16_t port, const Addr& addr, Ts&&... ts) {
                 getServer(port).subscribe(addr, std::forward<Ts>(ts)...);
             }
 
@@ -310,6 +792,26 @@ namespace osc {
                 for (auto& m : server_map)
                     m.second->parse();
             }
+
+            // drain all servers within the budget, returns the total number of handled packets
+            // servers are read in turn one packet at a time, so that a busy port doesn't starve the others
+            size_t parse(const size_t max_packets, const uint32_t max_micros = 0) {
+                const uint32_t begin_us = micros();
+                size_t n = 0;
+                bool pending = true;
+                while (pending && (n < max_packets)) {
+                    pending = false;
+                    for (auto& m : server_map) {
+                        if (n >= max_packets) break;
+                        if (max_micros && ((uint32_t)(micros() - begin_us) >= max_micros)) return n;
+                        if (m.second->parse(1)) {
+                            ++n;
+                            pending = true;
+                        }
+                    }
+                }
+                return n;
+            }
         };
 
     }  // namespace server
@@ -7,87 +7,202 @@
 #include <DebugLog.h>
 #include "OscTypes.h"
 #include "OscMessage.h"
+#include "OscMessageView.h"
+
+#ifndef ARDUINOOSC_MAX_BUNDLE_DEPTH
+#define ARDUINOOSC_MAX_BUNDLE_DEPTH 4
+#endif
 
 namespace arduino {
 namespace osc {
     namespace message {
 
+        // walk the messages in a packet one by one, without recursion and without copying them
+        // nested bundles are tracked with a fixed stack of ARDUINOOSC_MAX_BUNDLE_DEPTH frames,
+        // and the walk stops at the first corrupted element
+        class BundleWalker {
+            struct Frame {
+                const char* end;
+                TimeTag time_tag;
+            };
+            Frame frames[ARDUINOOSC_MAX_BUNDLE_DEPTH];
+            size_t depth {0};
+            const char* pos {nullptr};
+            const char* end {nullptr};
+            bool broken {false};
+
+        public:
+            BundleWalker() {}
+
+            BundleWalker(const void* ptr, const size_t sz) {
+                init(ptr, sz);
+            }
+
+            bool init(const void* ptr, const size_t sz) {
+                depth = 0;
+                pos = end = nullptr;
+                broken = false;
+                if ((sz == 0) || ((sz % 4) != 0)) {
+                    LOG_ERROR(F("parse message failed"));
+                    broken = true;
+                    return false;
+                }
+                pos = (const char*)ptr;
+                end = pos + sz;
+                return true;
+            }
+
+            // get the next message element and its bundle time tag
+            // returns false at the end of the packet or if it was corrupted
+            bool next(const char*& msg_beg, size_t& msg_size, TimeTag& msg_time_tag) {
+                while (pos) {
+                    while (depth && (pos == frames[depth - 1].end)) --depth;
+                    if (pos == end) break;
+
+                    const char* elem_end = end;
+                    TimeTag tt = TimeTag::immediate();
+                    if (depth) {
+                        const Frame& f = frames[depth - 1];
+                        if (f.end - pos < 4) return fail();
+                        const uint32_t sz = bytes2pod<uint32_t>(pos);
+                        pos += 4;
+                        if ((sz & 3) != 0 || pos + sz > f.end || pos + sz < pos) return fail();
+                        elem_end = pos + sz;
+                        tt = f.time_tag;
+                    }
+                    if (pos == elem_end) continue;  // empty element
+
+                    if (*pos == '#') {
+                        if ((elem_end - pos < 16) || (memcmp(pos, "#bundle\0", 8) != 0)) {
+                            LOG_ERROR(F("bundle header was corrupted"));
+                            return fail();
+                        }
+                        if (depth >= ARDUINOOSC_MAX_BUNDLE_DEPTH) {
+                            LOG_ERROR(F("bundle is nested too deeply"));
+                            return fail();
+                        }
+                        frames[depth].end = elem_end;
+                        frames[depth].time_tag = TimeTag(bytes2pod<uint64_t>(pos + 8));
+                        ++depth;
+                        pos += 16;
+                    } else {
+                        msg_beg = pos;
+                        msg_size = elem_end - pos;
+                        msg_time_tag = tt;
+                        pos = elem_end;
+                        return true;
+                    }
+                }
+                pos = nullptr;
+                return false;
+            }
+
+            bool corrupted() const { return broken; }
+
+        private:
+            bool fail() {
+                LOG_ERROR(F("bundle data structure was corrupted"));
+                pos = nullptr;
+                broken = true;
+                return false;
+            }
+        };
+
         class Decoder {
-            using MessageIterator = MessageQueue::iterator;
+            // the messages are kept as a pool and rebuilt in place for the next packet,
+            // so that their buffers are reused and nothing is allocated in the steady state
             MessageQueue messages;
-            MessageIterator it_messages;
+            size_t num_messages {0};
+            size_t cursor {0};
 
         public:
-            Decoder()
-            : messages(), it_messages(messages.begin()) {}
+            Decoder() {}
 
-            Decoder(const void* ptr, const size_t sz)
-            : messages(), it_messages(messages.begin()) {
+            Decoder(const void* ptr, const size_t sz) {
                 init(ptr, sz);
             }
 
+            // the messages decoded before a corrupted element are kept even if it fails
             bool init(const void* ptr, const size_t sz) {
-                messages.clear();
-                if ((sz % 4) == 0) {
-                    if (parse((const char*)ptr, (const char*)ptr + sz, TimeTag::immediate())) {
-                        it_messages = messages.begin();
-                        return true;
+                num_messages = cursor = 0;
+                BundleWalker walker;
+                if (walker.init(ptr, sz)) {
+                    const char* beg;
+                    size_t size;
+                    TimeTag tt;
+                    while (walker.next(beg, size, tt)) {
+                        if (!push(beg, size, tt)) return false;
                     }
+                    if (!walker.corrupted()) return true;
                 }
                 LOG_ERROR(F("parse message failed"));
                 return false;
             }
 
             Message* decode() {
-                if (messages.empty()) {
+                if (num_messages == 0) {
                     LOG_ERROR(F("message is empty"));
                     return nullptr;
                 }
-                if (it_messages == messages.end()) {
+                if (cursor == num_messages) {
                     LOG_ERROR(F("no more message to decode"));
                     return nullptr;
                 }
 
-                return &*it_messages++;
+                return &messages[cursor++];
             }
 
         private:
-            bool parse(const char* beg, const char* end, const TimeTag& time_tag) {
-                if (beg >= end) {
-                    LOG_ERROR(F("data ptr should be begin > end but it was:"), beg, ">=", end);
-                    return false;
-                }
-
-                if (*beg == '#') {
-                    if ((end - beg >= 20) && (memcmp(beg, "#bundle\0", 8) == 0)) {
-                        TimeTag tt(bytes2pod<uint64_t>(beg + 8));
-                        const char* pos = beg + 16;
-                        do {
-                            uint32_t sz = bytes2pod<uint32_t>(pos);
-                            pos += 4;
-                            if ((sz & 3) != 0 || pos + sz > end || pos + sz < pos) {
-                                LOG_ERROR(F("bundle data structure was corrupted"));
-                                return false;
-                            }
-                            parse(pos, pos + sz, tt);
-                            pos += sz;
-                        } while (pos != end);
-                    } else {
-                        LOG_ERROR(F("bundle header was corrupted"));
+            bool push(const char* beg, const size_t sz, const TimeTag& time_tag) {
+                if (num_messages == messages.size()) {
+                    const size_t prev_size = messages.size();
+                    messages.push_back(Message());
+                    if (messages.size() == prev_size) {
+                        LOG_ERROR(F("message queue overflow"));
                         return false;
                     }
-                } else {
-                    messages.push_back(Message(beg, end - beg, time_tag));
                 }
-
+                messages[num_messages++].init(beg, sz, time_tag);
                 return true;
             }
         };
 
+        // decode messages as MessageView without copying the packet
+        // the packet buffer must be kept until all views are consumed
+        class ViewDecoder {
+            BundleWalker walker;
+            MessageView view;
+
+        public:
+            ViewDecoder() {}
+
+            ViewDecoder(const void* ptr, const size_t sz) {
+                init(ptr, sz);
+            }
+
+            bool init(const void* ptr, const size_t sz) {
+                view.clear();
+                return walker.init(ptr, sz);
+            }
+
+            // returns the next message in the packet (nested bundles are walked in order)
+            // the returned view is valid until the next call of decode() or init()
+            const MessageView* decode() {
+                const char* beg;
+                size_t sz;
+                TimeTag tt;
+                if (!walker.next(beg, sz, tt)) return nullptr;
+                view.init(beg, sz, tt);
+                return &view;
+            }
+        };
+
     }  // namespace message
 }  // namespace osc
 }  // namespace arduino
 
 using OscDecoder = arduino::osc::message::Decoder;
+using OscViewDecoder = arduino::osc::message::ViewDecoder;
+using OscBundleWalker = arduino::osc::message::BundleWalker;
 
 #endif  // ARDUINOOSC_OSCDECODER_H
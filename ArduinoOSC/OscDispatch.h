@@ -0,0 +1,232 @@
+#pragma once
+
+#ifndef ARDUINOOSC_OSCDISPATCH_H
+#define ARDUINOOSC_OSCDISPATCH_H
+
+#include <Arduino.h>
+#include <DebugLog.h>
+#include "OscTypes.h"
+#include "OscUtil.h"
+#include "OscPatternAutomaton.h"
+#include "OscMethodTree.h"
+
+#ifndef ARDUINOOSC_PATTERN_AUTOMATON_THRESHOLD
+#define ARDUINOOSC_PATTERN_AUTOMATON_THRESHOLD 4  // a few patterns are faster with fullPatternMatch()
+#endif
+#ifndef ARDUINOOSC_DISPATCH_CACHE_SIZE
+#define ARDUINOOSC_DISPATCH_CACHE_SIZE 0  // disabled by default
+#endif
+
+namespace arduino {
+namespace osc {
+    namespace server {
+
+        struct DispatchEntry {
+            uint32_t hash;
+            const char* addr;  // points to the key in CallbackMap
+            element::Base* elem;
+        };
+
+        // index of the subscribed addresses to find the callbacks of an incoming address
+        // exact addresses are looked up by hash with a binary search,
+        // and only the real patterns (see isAddressPattern()) go to the pattern matcher
+        // if libstdc++ is available and there are ARDUINOOSC_PATTERN_AUTOMATON_THRESHOLD or more patterns,
+        // they are compiled into one automaton
+        // if message patterns are enabled, the plain addresses are also kept in a MethodTree
+        // and an incoming address pattern is expanded over it (OSC 1.0 dispatching)
+        // it must be rebuilt whenever the CallbackMap is changed
+        class DispatchIndex {
+            DispatchEntries exact;     // sorted by hash
+            DispatchEntries patterns;  // in the order of CallbackMap
+#if ARX_HAVE_LIBSTDCPLUSPLUS >= 201103L  // Have libstdc++11
+            PatternAutomaton automaton;
+            DispatchEntries fallback;  // patterns which the automaton doesn't support
+#endif
+#ifndef ARDUINOOSC_DISABLE_METHOD_TREE
+            MethodTree methods;
+#endif
+            bool message_patterns {false};
+
+        public:
+            void build(const CallbackMap& callbacks, const bool enable_message_patterns = false) {
+                exact.clear();
+                patterns.clear();
+#ifdef ARDUINOOSC_DISABLE_METHOD_TREE
+                if (enable_message_patterns) LOG_ERROR(F("message patterns are disabled, define ARDUINOOSC_MAX_METHOD_TREE_NODES to use them"));
+                message_patterns = false;
+#else
+                methods.clear();
+                message_patterns = enable_message_patterns;
+#endif
+#if ARX_HAVE_LIBSTDCPLUSPLUS >= 201103L  // Have libstdc++11
+                automaton.clear();
+                fallback.clear();
+#endif
+                for (auto& c : callbacks) {
+                    const char* addr = c.first.c_str();
+                    if (isAddressPattern(addr)) {
+                        patterns.push_back(DispatchEntry {0, addr, c.second.get()});
+                    } else {
+                        // insertion sort, subscriptions are few and rarely changed
+                        const DispatchEntry e {hashAddress(addr), addr, c.second.get()};
+                        exact.push_back(e);
+                        size_t i = exact.size() - 1;
+                        for (; (i > 0) && (exact[i - 1].hash > e.hash); --i) exact[i] = exact[i - 1];
+                        exact[i] = e;
+#ifndef ARDUINOOSC_DISABLE_METHOD_TREE
+                        if (message_patterns) methods.add(addr, e.elem);
+#endif
+                    }
+                }
+#if ARX_HAVE_LIBSTDCPLUSPLUS >= 201103L  // Have libstdc++11
+                const bool compile = patterns.size() >= ARDUINOOSC_PATTERN_AUTOMATON_THRESHOLD;
+                for (size_t i = 0; i < patterns.size(); ++i) {
+                    if (!compile || !automaton.add(patterns[i].addr, (uint32_t)i))
+                        fallback.push_back(patterns[i]);
+                }
+#endif
+            }
+
+            size_t numExact() const { return exact.size(); }
+            size_t numPatterns() const { return patterns.size(); }
+            bool messagePatterns() const { return message_patterns; }
+
+            // call f(element::Base*) for each subscription which matches the address
+            // an address pattern matches only the plain addresses if message patterns are enabled
+            template <typename F>
+            void lookup(const char* addr, F&& f) const {
+#ifndef ARDUINOOSC_DISABLE_METHOD_TREE
+                if (message_patterns && isAddressPattern(addr)) {
+                    methods.match(addr, f);
+                    return;
+                }
+#endif
+                if (!exact.empty()) {
+                    const uint32_t h = hashAddress(addr);
+                    size_t lo = 0, hi = exact.size();
+                    while (lo < hi) {
+                        const size_t mid = (lo + hi) / 2;
+                        if (exact[mid].hash < h)
+                            lo = mid + 1;
+                        else
+                            hi = mid;
+                    }
+                    for (; (lo < exact.size()) && (exact[lo].hash == h); ++lo) {
+                        if (strcmp(exact[lo].addr, addr) == 0) f(exact[lo].elem);
+                    }
+                }
+#if ARX_HAVE_LIBSTDCPLUSPLUS >= 201103L  // Have libstdc++11
+                if (fallback.size() != patterns.size()) automaton.match(addr, [&](const uint32_t id) { f(patterns[id].elem); });
+                for (auto& p : fallback) {
+                    if (fullPatternMatch(p.addr, addr)) f(p.elem);
+                }
+#else
+                for (auto& p : patterns) {
+                    if (fullPatternMatch(p.addr, addr)) f(p.elem);
+                }
+#endif
+            }
+        };
+
+#ifndef ARDUINOOSC_DISABLE_DISPATCH_CACHE
+        struct DispatchCacheSlot {
+            bool valid {false};
+            uint32_t hash {0};
+            String addr;
+            DispatchElements elems;
+        };
+#endif
+
+        // direct-mapped cache of the lookup results of DispatchIndex by address hash
+        // a repeated address is dispatched with one hash and one strcmp however many patterns are subscribed
+        // the results (including "no callback") are valid until the index is rebuilt
+        class DispatchCache {
+        public:
+            struct Stats {
+                uint32_t hits {0};
+                uint32_t misses {0};
+                uint32_t evictions {0};      // slots overwritten by another address
+                uint32_t invalidations {0};  // cleared by subscribe() / unsubscribe()
+            };
+
+        private:
+#ifndef ARDUINOOSC_DISABLE_DISPATCH_CACHE
+            DispatchCacheSlots slots;
+            size_t mask {0};
+#endif
+            Stats stat;
+
+        public:
+#ifdef ARDUINOOSC_DISABLE_DISPATCH_CACHE
+            void resize(const size_t n) {
+                if (n) LOG_ERROR(F("dispatch cache is disabled, define ARDUINOOSC_MAX_DISPATCH_CACHE_SIZE to use it"));
+            }
+            bool enabled() const { return false; }
+            size_t size() const { return 0; }
+            const Stats& stats() const { return stat; }
+            void resetStats() { stat = Stats(); }
+            void invalidate() {}
+
+            template <typename F>
+            void lookup(const DispatchIndex& index, const char* addr, F&& f) {
+                index.lookup(addr, f);
+            }
+#else
+            // the number of slots is rounded down to a power of two, 0 disables the cache
+            void resize(size_t n) {
+                if (n > ARDUINOOSC_MAX_DISPATCH_CACHE_SIZE) n = ARDUINOOSC_MAX_DISPATCH_CACHE_SIZE;
+                size_t sz = n ? 1 : 0;
+                while (sz && (sz * 2 <= n)) sz *= 2;
+                slots.clear();
+                for (size_t i = 0; i < sz; ++i) slots.push_back(DispatchCacheSlot());
+                mask = sz ? (sz - 1) : 0;
+            }
+
+            bool enabled() const { return !slots.empty(); }
+            size_t size() const { return slots.size(); }
+            const Stats& stats() const { return stat; }
+            void resetStats() { stat = Stats(); }
+
+            void invalidate() {
+                bool any = false;
+                for (auto& s : slots) {
+                    any |= s.valid;
+                    s.valid = false;
+                }
+                if (any) ++stat.invalidations;
+            }
+
+            // call f(element::Base*) for each subscription which matches the address
+            // the index is looked up only if the address is not cached
+            template <typename F>
+            void lookup(const DispatchIndex& index, const char* addr, F&& f) {
+                if (!enabled()) {
+                    index.lookup(addr, f);
+                    return;
+                }
+                const uint32_t h = hashAddress(addr);
+                DispatchCacheSlot& s = slots[h & mask];
+                if (s.valid && (s.hash == h) && (strcmp(s.addr.c_str(), addr) == 0)) {
+                    ++stat.hits;
+                } else {
+                    ++stat.misses;
+                    if (s.valid) ++stat.evictions;
+                    s.valid = true;
+                    s.hash = h;
+                    s.addr = addr;
+                    s.elems.clear();
+                    index.lookup(addr, [&](element::Base* e) { s.elems.push_back(e); });
+                }
+                for (auto* e : s.elems) f(e);
+            }
+#endif  // ARDUINOOSC_DISABLE_DISPATCH_CACHE
+        };
+
+    }  // namespace server
+}  // namespace osc
+}  // namespace arduino
+
+using OscDispatchIndex = arduino::osc::server::DispatchIndex;
+using OscDispatchCache = arduino::osc::server::DispatchCache;
+
+#endif  // ARDUINOOSC_OSCDISPATCH_H
@@ -0,0 +1,285 @@
+#pragma once
+
+#ifndef ARDUINOOSC_OSCDISPATCHEXECUTOR_H
+#define ARDUINOOSC_OSCDISPATCHEXECUTOR_H
+
+#include <Arduino.h>
+#include <DebugLog.h>
+#include "OscTypes.h"
+#include "OscMessage.h"
+#include "OscElementPool.h"
+
+#ifdef ARDUINOOSC_HAVE_THREAD
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifndef ARDUINOOSC_DISPATCH_QUEUE_SIZE
+#define ARDUINOOSC_DISPATCH_QUEUE_SIZE 64  // per worker
+#endif
+
+namespace arduino {
+namespace osc {
+    namespace server {
+
+        using namespace message;
+
+        // runs the callbacks of the dispatched messages in worker threads
+        // the messages of a subscription go to the same worker in order, so a callback is never called
+        // concurrently with itself, and the callbacks of other subscriptions run in parallel
+        // messages of an unordered subscription (see Server::unordered()) can be stolen by idle workers
+        // and may be handled out of order, but still one at a time per subscription
+        // a callback must not call wait() (e.g. through unsubscribe()), which would wait for the callback itself
+        class DispatchExecutor {
+        public:
+            struct Stats {
+                uint32_t submitted {0};
+                uint32_t executed {0};
+                uint32_t stolen {0};  // unordered messages handled by another worker
+                uint32_t stalls {0};  // submit() waited because the queue of the worker was full
+            };
+
+        private:
+            struct Task {
+                Message msg;
+                element::Base* elem {nullptr};
+            };
+
+            // bounded FIFO of tasks, guarded by the mutex of the worker
+            // the messages in the slots are reused, so that copying a message doesn't allocate
+            class TaskQueue {
+                std::vector<Task> tasks;
+                size_t head {0};
+                size_t count {0};
+
+            public:
+                void resize(const size_t n) {
+                    tasks.resize(n ? n : 1);
+                    head = count = 0;
+                }
+                bool empty() const { return count == 0; }
+                bool full() const { return count == tasks.size(); }
+                size_t size() const { return count; }
+                void push(element::Base* elem, const Message& m) {
+                    Task& t = tasks[(head + count) % tasks.size()];
+                    t.msg = m;
+                    t.elem = elem;
+                    ++count;
+                }
+                // swap the oldest task into t, the old buffers of t are left in the slot
+                void pop(Task& t) {
+                    Task& front = tasks[head];
+                    std::swap(front.msg, t.msg);
+                    t.elem = front.elem;
+                    head = (head + 1) % tasks.size();
+                    --count;
+                }
+            };
+
+            struct Worker {
+                std::mutex mtx;
+                std::condition_variable has_task;
+                std::condition_variable has_space;
+                TaskQueue ordered;
+                TaskQueue unordered;
+                Task current;
+                std::atomic<bool> sleeping {false};  // waiting for has_task, so submit() has to wake it to steal
+                std::thread th;
+            };
+
+            static constexpr size_t NUM_STRIPES = 32;
+
+            std::vector<std::unique_ptr<Worker>> workers;
+            std::mutex stripes[NUM_STRIPES];  // one unordered subscription runs at a time
+            std::atomic<bool> running {false};
+            std::atomic<size_t> pending {0};
+            std::atomic<size_t> unordered_queued {0};  // in the unordered queues of all workers
+            std::mutex idle_mtx;
+            std::condition_variable idle;
+            size_t next_unordered {0};
+
+            std::atomic<uint32_t> num_submitted {0};
+            std::atomic<uint32_t> num_executed {0};
+            std::atomic<uint32_t> num_stolen {0};
+            std::atomic<uint32_t> num_stalls {0};
+
+        public:
+            ~DispatchExecutor() { stop(); }
+
+            // start n workers, each with a queue of queue_size messages
+            bool start(const size_t n, const size_t queue_size = ARDUINOOSC_DISPATCH_QUEUE_SIZE) {
+                if (running.load() || (n == 0)) return false;
+                running.store(true);
+                workers.clear();
+                for (size_t i = 0; i < n; ++i) {
+                    workers.emplace_back(new Worker());
+                    workers.back()->ordered.resize(queue_size);
+                    workers.back()->unordered.resize(queue_size);
+                }
+                for (size_t i = 0; i < n; ++i) workers[i]->th = std::thread([this, i] { run(i); });
+                return true;
+            }
+
+            // the queued messages are handled before the workers exit
+            void stop() {
+                if (!running.exchange(false)) return;
+                for (auto& w : workers) {
+                    {
+                        std::lock_guard<std::mutex> lock(w->mtx);
+                    }
+                    w->has_task.notify_all();
+                    w->has_space.notify_all();
+                }
+                for (auto& w : workers)
+                    if (w->th.joinable()) w->th.join();
+                workers.clear();
+            }
+
+            bool isRunning() const { return running.load(); }
+            size_t numWorkers() const { return workers.size(); }
+
+            Stats stats() const {
+                Stats s;
+                s.submitted = num_submitted.load(std::memory_order_relaxed);
+                s.executed = num_executed.load(std::memory_order_relaxed);
+                s.stolen = num_stolen.load(std::memory_order_relaxed);
+                s.stalls = num_stalls.load(std::memory_order_relaxed);
+                return s;
+            }
+
+            // queue the message for the element, called from the thread which parses the messages
+            // it waits if the queue of the worker is full
+            void submit(element::Base* elem, const Message& m) {
+                const bool unordered = elem->unordered();
+                Worker& w = unordered ? *workers[next_unordered++ % workers.size()] : *workers[shard(elem)];
+                TaskQueue& q = unordered ? w.unordered : w.ordered;
+                pending.fetch_add(1);
+                {
+                    std::unique_lock<std::mutex> lock(w.mtx);
+                    if (q.full()) {
+                        num_stalls.fetch_add(1, std::memory_order_relaxed);
+                        w.has_space.wait(lock, [&] { return !q.full(); });
+                    }
+                    q.push(elem, m);
+                    if (unordered) unordered_queued.fetch_add(1);
+                }
+                w.has_task.notify_one();
+                // the other workers sleep without timeout, so wake the idle ones to steal it
+                if (unordered) {
+                    for (auto& o : workers) {
+                        if ((o.get() == &w) || !o->sleeping.load()) continue;
+                        {
+                            std::lock_guard<std::mutex> lock(o->mtx);
+                        }
+                        o->has_task.notify_one();
+                    }
+                }
+                num_submitted.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            // wait until all the queued messages are handled
+            // e.g. before the subscribed elements are released
+            // returns false without waiting if it is called from a callback in a worker, which would deadlock
+            bool wait() {
+                if (worker_of() == this) {
+                    LOG_ERROR(F("wait() is called from a dispatched callback, which would wait for itself"));
+                    return false;
+                }
+                std::unique_lock<std::mutex> lock(idle_mtx);
+                idle.wait(lock, [&] { return pending.load() == 0; });
+                return true;
+            }
+
+        private:
+            // the executor whose worker is the current thread
+            static const DispatchExecutor*& worker_of() {
+                static thread_local const DispatchExecutor* e = nullptr;
+                return e;
+            }
+
+            size_t shard(const element::Base* elem) const {
+                uintptr_t h = (uintptr_t)elem;
+                h ^= h >> 7;
+                h *= 0x9E3779B1UL;
+                return (size_t)(h >> 8) % workers.size();
+            }
+
+            std::mutex& stripe(const element::Base* elem) {
+                return stripes[((uintptr_t)elem >> 4) % NUM_STRIPES];
+            }
+
+            void run(const size_t i) {
+                Worker& w = *workers[i];
+                worker_of() = this;
+                while (true) {
+                    bool unordered = false;
+                    bool found = false;
+                    {
+                        std::unique_lock<std::mutex> lock(w.mtx);
+                        // sleep until a task is queued here, or an unordered one anywhere (see submit())
+                        w.sleeping.store(true);
+                        w.has_task.wait(lock, [&] {
+                            return !w.ordered.empty() || (unordered_queued.load() > 0) || !running.load();
+                        });
+                        w.sleeping.store(false);
+                        if (!w.ordered.empty()) {
+                            w.ordered.pop(w.current);
+                            found = true;
+                        } else if (!w.unordered.empty()) {
+                            w.unordered.pop(w.current);
+                            unordered_queued.fetch_sub(1);
+                            found = unordered = true;
+                        }
+                    }
+                    if (found) {
+                        w.has_space.notify_one();
+                    } else if (steal(i)) {
+                        found = unordered = true;
+                    } else if (!running.load()) {
+                        break;
+                    }
+                    if (!found) continue;
+
+                    if (unordered) {
+                        std::lock_guard<std::mutex> lock(stripe(w.current.elem));
+                        w.current.elem->decodeFrom(w.current.msg);
+                    } else {
+                        w.current.elem->decodeFrom(w.current.msg);
+                    }
+                    num_executed.fetch_add(1, std::memory_order_relaxed);
+                    if (pending.fetch_sub(1) == 1) {
+                        std::lock_guard<std::mutex> lock(idle_mtx);
+                        idle.notify_all();
+                    }
+                }
+            }
+
+            // take the oldest unordered message of another worker
+            bool steal(const size_t thief) {
+                Worker& w = *workers[thief];
+                for (size_t k = 1; k < workers.size(); ++k) {
+                    Worker& victim = *workers[(thief + k) % workers.size()];
+                    std::unique_lock<std::mutex> lock(victim.mtx, std::try_to_lock);
+                    if (!lock.owns_lock() || victim.unordered.empty()) continue;
+                    victim.unordered.pop(w.current);
+                    unordered_queued.fetch_sub(1);
+                    lock.unlock();
+                    victim.has_space.notify_one();
+                    num_stolen.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+                return false;
+            }
+        };
+
+    }  // namespace server
+}  // namespace osc
+}  // namespace arduino
+
+using OscDispatchExecutor = arduino::osc::server::DispatchExecutor;
+
+#endif  // ARDUINOOSC_HAVE_THREAD
+
+#endif  // ARDUINOOSC_OSCDISPATCHEXECUTOR_H
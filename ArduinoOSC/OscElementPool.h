@@ -0,0 +1,161 @@
+#pragma once
+
+#ifndef ARDUINOOSC_OSCELEMENTPOOL_H
+#define ARDUINOOSC_OSCELEMENTPOOL_H
+
+#include <Arduino.h>
+#include "OscTypes.h"
+#include "OscMessage.h"
+
+#if ARX_HAVE_LIBSTDCPLUSPLUS >= 201103L  // Have libstdc++11
+#ifndef ARDUINOOSC_ELEMENT_POOL_SIZE
+#define ARDUINOOSC_ELEMENT_POOL_SIZE 32
+#endif
+#ifndef ARDUINOOSC_ELEMENT_SLOT_SIZE
+#define ARDUINOOSC_ELEMENT_SLOT_SIZE 64
+#endif
+#else
+#ifndef ARDUINOOSC_ELEMENT_POOL_SIZE
+#define ARDUINOOSC_ELEMENT_POOL_SIZE (ARDUINOOSC_MAX_SUBSCRIBE_ADDRESS_PER_PORT * ARDUINOOSC_MAX_SUBSCRIBE_PORTS)
+#endif
+#ifndef ARDUINOOSC_ELEMENT_SLOT_SIZE
+#define ARDUINOOSC_ELEMENT_SLOT_SIZE 16
+#endif
+#endif
+
+namespace arduino {
+namespace osc {
+    namespace server {
+        namespace element {
+
+            // fixed table of slots for the subscribed elements
+            // an element which is larger than a slot, or doesn't fit in the table, is allocated on the heap
+            class Pool {
+                union Slot {
+                    Slot* next;  // while the slot is free
+                    long long align_ll;
+                    double align_d;
+                    void* align_p;
+                    unsigned char bytes[ARDUINOOSC_ELEMENT_SLOT_SIZE];
+                };
+
+                Slot slots[ARDUINOOSC_ELEMENT_POOL_SIZE];
+                Slot* free_list {nullptr};
+                size_t num_used {0};
+
+                Pool() {
+                    for (size_t i = ARDUINOOSC_ELEMENT_POOL_SIZE; i > 0; --i) {
+                        slots[i - 1].next = free_list;
+                        free_list = &slots[i - 1];
+                    }
+                }
+                Pool(const Pool&) = delete;
+                Pool& operator=(const Pool&) = delete;
+
+            public:
+                static Pool& getInstance() {
+                    static Pool p;
+                    return p;
+                }
+
+                static constexpr size_t slotSize() { return sizeof(Slot); }
+                static constexpr size_t capacity() { return ARDUINOOSC_ELEMENT_POOL_SIZE; }
+                size_t used() const { return num_used; }
+
+                void* allocate(const size_t sz) {
+                    if ((sz > sizeof(Slot)) || !free_list) return ::operator new(sz);
+                    Slot* s = free_list;
+                    free_list = s->next;
+                    ++num_used;
+                    return s;
+                }
+
+                void deallocate(void* p) {
+                    if (!contains(p)) {
+                        ::operator delete(p);
+                        return;
+                    }
+                    Slot* s = (Slot*)p;
+                    s->next = free_list;
+                    free_list = s;
+                    --num_used;
+                }
+
+                bool contains(const void* p) const {
+                    return ((const unsigned char*)p >= (const unsigned char*)slots)
+                        && ((const unsigned char*)p < (const unsigned char*)(slots + ARDUINOOSC_ELEMENT_POOL_SIZE));
+                }
+            };
+
+            // subscribed element, which is placed in the Pool and owned by Ref
+            class Base {
+                friend class Ref;
+                uint16_t refs {0};
+                bool is_unordered {false};
+
+            public:
+                virtual ~Base() {}
+                virtual void decodeFrom(message::Message& m, const size_t offset = 0) = 0;
+
+                // messages may be handled out of order by the dispatch workers (see DispatchExecutor)
+                void unordered(const bool b) { is_unordered = b; }
+                bool unordered() const { return is_unordered; }
+
+                static void* operator new(const size_t sz) { return Pool::getInstance().allocate(sz); }
+                // sized, so that g++ sees it paired with operator new above (-Wmismatched-new-delete)
+                static void operator delete(void* p, const size_t) { Pool::getInstance().deallocate(p); }
+            };
+
+            // intrusive reference count of the element, without a separate control block
+            // the count is not atomic, subscribe and unsubscribe from one thread
+            class Ref {
+                Base* ptr {nullptr};
+
+            public:
+                Ref() {}
+                explicit Ref(Base* p)
+                : ptr(p) {
+                    if (ptr) ++ptr->refs;
+                }
+                Ref(const Ref& r)
+                : Ref(r.ptr) {}
+                Ref(Ref&& r)
+                : ptr(r.ptr) {
+                    r.ptr = nullptr;
+                }
+                ~Ref() { reset(); }
+
+                Ref& operator=(const Ref& r) {
+                    Ref(r).swap(*this);
+                    return *this;
+                }
+                Ref& operator=(Ref&& r) {
+                    Ref(std::move(r)).swap(*this);
+                    return *this;
+                }
+
+                void reset() {
+                    if (ptr && (--ptr->refs == 0)) delete ptr;
+                    ptr = nullptr;
+                }
+                void swap(Ref& r) {
+                    Base* p = ptr;
+                    ptr = r.ptr;
+                    r.ptr = p;
+                }
+
+                Base* get() const { return ptr; }
+                Base* operator->() const { return ptr; }
+                Base& operator*() const { return *ptr; }
+                explicit operator bool() const { return ptr != nullptr; }
+                size_t use_count() const { return ptr ? ptr->refs : 0; }
+            };
+
+        }  // namespace element
+    }  // namespace server
+}  // namespace osc
+}  // namespace arduino
+
+using OscElementPool = arduino::osc::server::element::Pool;
+
+#endif  // ARDUINOOSC_OSCELEMENTPOOL_H
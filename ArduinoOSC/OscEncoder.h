@@ -7,67 +7,344 @@
 #include "OscTypes.h"
 #include "OscMessage.h"
 
+#ifndef ARDUINOOSC_STREAM_ENCODER_BUFFER_SIZE
+#define ARDUINOOSC_STREAM_ENCODER_BUFFER_SIZE 32
+#endif
+
 namespace arduino {
 namespace osc {
     namespace message {
 
         class Encoder {
             Storage storage;
+            BufferStorage buffer;  // used instead of storage if a buffer is given to init()
+            bool overflowed {false};
 
 #ifndef ARDUINOOSC_DISABLE_BUNDLE
+            // offsets of the open bundles, NOT_WRITTEN if begin_bundle() overflowed
             BundleData bundles;
+            static constexpr uint32_t NOT_WRITTEN = 0xFFFFFFFF;
 #endif
 
         public:
+            // the state to be restored by rollback()
+            struct Checkpoint {
+                size_t size;
+                size_t depth;
+            };
+
             Encoder() {
                 init();
             }
+            Encoder(char* buf, const size_t capacity) {
+                init(buf, capacity);
+            }
 
             Encoder& init() {
-                storage.clear();
-#ifndef ARDUINOOSC_DISABLE_BUNDLE
-                bundles.clear();
-#endif
-                return *this;
+                buffer = BufferStorage();
+                return reset();
+            }
+
+            // encode into the caller-supplied buffer, which must outlive the encoding
+            Encoder& init(char* buf, const size_t capacity) {
+                buffer = BufferStorage(buf, capacity);
+                return reset();
             }
 
             Encoder& encode(const Message& msg) {
 #ifdef ARDUINOOSC_DISABLE_BUNDLE
-                msg.encode(storage, false);
+                const bool write_size = false;
 #else
-                msg.encode(storage, !bundles.empty());
+                const bool write_size = !bundles.empty();
 #endif
+                const bool ok = buffer.buf ? msg.encode(buffer, write_size) : msg.encode(storage, write_size);
+                if (!ok) overflowed = true;
                 return *this;
             }
 
-            uint32_t size() const { return (uint32_t)storage.size(); }
-            const uint8_t* data() const { return (const uint8_t*)storage.begin(); }
+            uint32_t size() const { return (uint32_t)(buffer.buf ? buffer.size() : storage.size()); }
+            const uint8_t* data() const { return (const uint8_t*)(buffer.buf ? buffer.begin() : storage.begin()); }
+
+            // true if something could not be encoded since init() or the last rollback()
+            // the bytes which didn't fit are never written partially
+            bool overflow() const { return overflowed; }
+
+            Checkpoint checkpoint() const {
+#ifdef ARDUINOOSC_DISABLE_BUNDLE
+                return Checkpoint {size(), 0};
+#else
+                return Checkpoint {size(), bundles.size()};
+#endif
+            }
+
+            // drop everything encoded after the checkpoint, e.g. the message which didn't fit
+            // a bundle which was open at the checkpoint must not be ended before the rollback,
+            // otherwise nothing is dropped and overflow() becomes true
+            Encoder& rollback(const Checkpoint& cp) {
+#ifndef ARDUINOOSC_DISABLE_BUNDLE
+                if (bundles.size() < cp.depth) {
+                    LOG_ERROR(F("rollback failed: the bundle of the checkpoint was already ended"));
+                    overflowed = true;
+                    return *this;
+                }
+#endif
+                if (buffer.buf)
+                    buffer.resize(cp.size);
+                else
+                    storage.resize(cp.size);
+#ifndef ARDUINOOSC_DISABLE_BUNDLE
+                while (bundles.size() > cp.depth) bundles.pop_back();
+#endif
+                overflowed = false;
+                return *this;
+            }
 
 #ifndef ARDUINOOSC_DISABLE_BUNDLE
 
             Encoder& begin_bundle(const TimeTag& ts = TimeTag::immediate()) {
-                char* p;
-                if (bundles.size()) p = storage.getBytes(4);  // hold the bundle size
-                p = storage.getBytes(8);
+                const size_t offset = bundles.size() ? 4 : 0;  // hold the bundle size
+                char* p = getBytes(offset + 16);
+                if (!p) {
+                    // the matching end_bundle() pops this frame instead of patching the enclosing bundle
+                    bundles.push_back(uint32_t(NOT_WRITTEN));
+                    return *this;
+                }
+                p += offset;
                 strcpy(p, "#bundle");
-                bundles.push_back(p - storage.begin());
-                p = storage.getBytes(8);
-                pod2bytes<uint64_t>(ts, p);
+                bundles.push_back(p - begin());
+                pod2bytes<uint64_t>(ts, p + 8);
                 return *this;
             }
 
             Encoder& end_bundle() {
-                if (bundles.size()) {
-                    if (storage.size() - bundles.back() == 16)
-                        pod2bytes<uint32_t>(0, storage.getBytes(4));  // the 'empty bundle' case, not very elegant
-                    if (bundles.size() > 1)
-                        pod2bytes<uint32_t>(uint32_t(storage.size() - bundles.back()), storage.begin() + bundles.back() - 4);
-                    bundles.pop_back();
+                if (bundles.empty()) return *this;
+                const uint32_t beg = bundles.back();
+                bundles.pop_back();
+                if (beg == NOT_WRITTEN) return *this;
+                if (size() - beg == 16) {
+                    char* p = getBytes(4);  // the 'empty bundle' case, not very elegant
+                    if (!p) return *this;
+                    pod2bytes<uint32_t>(0, p);
                 }
+                if (bundles.size())
+                    pod2bytes<uint32_t>(uint32_t(size() - beg), begin() + beg - 4);
                 return *this;
             }
 
 #endif  // ARDUINOOSC_DISABLE_BUNDLE
+
+        private:
+            Encoder& reset() {
+                storage.clear();
+                overflowed = false;
+#ifndef ARDUINOOSC_DISABLE_BUNDLE
+                bundles.clear();
+#endif
+                return *this;
+            }
+
+            char* getBytes(const size_t sz) {
+                char* p = buffer.buf ? buffer.getBytes(sz) : storage.getBytes(sz);
+                if (!p) overflowed = true;
+                return p;
+            }
+            char* begin() { return buffer.buf ? buffer.begin() : storage.begin(); }
+        };
+
+        namespace stream {
+
+            // type tags and bytes of each argument, same as Message::push()
+            template <typename T>
+            struct is_int32 {
+                static constexpr bool value = std::is_integral<T>::value
+                    && !std::is_same<T, bool>::value
+                    && !std::is_same<T, long long>::value
+                    && !std::is_same<T, unsigned long long>::value;
+            };
+            template <typename T>
+            struct is_int64 {
+                static constexpr bool value = std::is_same<T, long long>::value || std::is_same<T, unsigned long long>::value;
+            };
+
+            inline size_t numTags(const bool&) { return 1; }
+            template <typename T>
+            inline auto numTags(const T&) -> std::enable_if_t<std::is_arithmetic<T>::value, size_t> { return 1; }
+            inline size_t numTags(const char*) { return 1; }
+            inline size_t numTags(const String&) { return 1; }
+            inline size_t numTags(const StringView&) { return 1; }
+            inline size_t numTags(const Blob&) { return 1; }
+            inline size_t numTags(const BlobView&) { return 1; }
+
+            template <typename W>
+            inline void writeTags(W& w, const bool& b) { w.put(b ? TYPE_TAG_TRUE : TYPE_TAG_FALSE); }
+            template <typename W, typename T>
+            inline auto writeTags(W& w, const T&) -> std::enable_if_t<is_int32<T>::value> { w.put(TYPE_TAG_INT32); }
+            template <typename W, typename T>
+            inline auto writeTags(W& w, const T&) -> std::enable_if_t<is_int64<T>::value> { w.put(TYPE_TAG_INT64); }
+            template <typename W>
+            inline void writeTags(W& w, const float&) { w.put(TYPE_TAG_FLOAT); }
+            template <typename W>
+            inline void writeTags(W& w, const double&) { w.put(TYPE_TAG_DOUBLE); }
+            template <typename W>
+            inline void writeTags(W& w, const char*) { w.put(TYPE_TAG_STRING); }
+            template <typename W>
+            inline void writeTags(W& w, const String&) { w.put(TYPE_TAG_STRING); }
+            template <typename W>
+            inline void writeTags(W& w, const StringView&) { w.put(TYPE_TAG_STRING); }
+            template <typename W>
+            inline void writeTags(W& w, const Blob&) { w.put(TYPE_TAG_BLOB); }
+            template <typename W>
+            inline void writeTags(W& w, const BlobView&) { w.put(TYPE_TAG_BLOB); }
+
+            template <typename W>
+            inline void writeArg(W&, const bool&) {}
+            template <typename W, typename T>
+            inline auto writeArg(W& w, const T& v) -> std::enable_if_t<is_int32<T>::value> { w.template putPod<int32_t>((int32_t)v); }
+            template <typename W, typename T>
+            inline auto writeArg(W& w, const T& v) -> std::enable_if_t<is_int64<T>::value> { w.template putPod<int64_t>((int64_t)v); }
+            template <typename W>
+            inline void writeArg(W& w, const float& v) { w.template putPod<float>(v); }
+            template <typename W>
+            inline void writeArg(W& w, const double& v) { w.template putPod<double>(v); }
+            template <typename W>
+            inline void writeArg(W& w, const StringView& v) {
+                w.write(v.data(), v.size());
+                w.pad(v.size(), 1);
+            }
+            template <typename W>
+            inline void writeArg(W& w, const char* v) { writeArg(w, StringView(v)); }
+            template <typename W>
+            inline void writeArg(W& w, const String& v) { writeArg(w, StringView(v)); }
+            template <typename W>
+            inline void writeArg(W& w, const BlobView& v) {
+                w.template putPod<int32_t>((int32_t)v.size());
+                w.write(v.data(), v.size());
+                w.pad(v.size(), 0);
+            }
+            template <typename W>
+            inline void writeArg(W& w, const Blob& v) { writeArg(w, BlobView(v)); }
+
+#if ARX_HAVE_LIBSTDCPLUSPLUS >= 201103L  // Have libstdc++11
+            template <typename T>
+            inline size_t numTags(const std::vector<T>& v) { return v.size(); }
+            template <typename W, typename T>
+            inline void writeTags(W& w, const std::vector<T>& v) {
+                for (const auto& t : v) writeTags(w, t);
+            }
+            template <typename W, typename T>
+            inline void writeArg(W& w, const std::vector<T>& v) {
+                for (const auto& t : v) writeArg(w, t);
+            }
+#endif
+
+        }  // namespace stream
+
+        // encode a message directly into a stream (e.g. UDP packet between beginPacket() and endPacket())
+        // without building Message and Encoder storage
+        // small pieces are gathered in a small buffer and large strings/blobs are written as is
+        template <typename S>
+        class StreamEncoder {
+            S& stream;
+            char buf[ARDUINOOSC_STREAM_ENCODER_BUFFER_SIZE];
+            size_t buf_size {0};
+            size_t written {0};
+
+        public:
+            explicit StreamEncoder(S& s)
+            : stream(s) {}
+            ~StreamEncoder() { flush(); }
+
+            // total bytes written to the stream (including the buffered ones)
+            size_t size() const { return written; }
+
+            StreamEncoder& encode(const Message& m) {
+                writeAddress(m.addressCStr());
+                const size_t l_type = m.size() + 2;
+                put(',');
+                write(m.typeTagsCStr(), m.size());
+                put(0);
+                pad(l_type, 0);
+                write(m.argsBegin(), m.argsEnd() - m.argsBegin());
+                return *this;
+            }
+
+            template <typename... Ts>
+            StreamEncoder& encode(const char* addr, const Ts&... ts) {
+                writeAddress(addr);
+                const size_t l_type = numTags(ts...) + 2;
+                put(',');
+                writeTags(ts...);
+                put(0);
+                pad(l_type, 0);
+                writeArgs(ts...);
+                return *this;
+            }
+            template <typename... Ts>
+            StreamEncoder& encode(const String& addr, const Ts&... ts) {
+                return encode(addr.c_str(), ts...);
+            }
+
+            void flush() {
+                if (buf_size) stream.write((const uint8_t*)buf, buf_size);
+                buf_size = 0;
+            }
+
+            void put(const char c) {
+                if (buf_size == sizeof(buf)) flush();
+                buf[buf_size++] = c;
+                ++written;
+            }
+
+            template <typename POD>
+            void putPod(const POD& v) {
+                if (buf_size + sizeof(POD) > sizeof(buf)) flush();
+                pod2bytes<POD>(v, buf + buf_size);
+                buf_size += sizeof(POD);
+                written += sizeof(POD);
+            }
+
+            void write(const void* data, const size_t n) {
+                if (n == 0) return;
+                if (buf_size + n <= sizeof(buf)) {
+                    memcpy(buf + buf_size, data, n);
+                    buf_size += n;
+                } else {
+                    flush();
+                    stream.write((const uint8_t*)data, n);
+                }
+                written += n;
+            }
+
+            // zero padding after n bytes, with at least min_zeros zeros
+            void pad(const size_t n, const size_t min_zeros) {
+                const size_t zeros = ceil4(n + min_zeros) - n;
+                for (size_t i = 0; i < zeros; ++i) put(0);
+            }
+
+        private:
+            void writeAddress(const char* addr) {
+                const size_t l_addr = strlen(addr);
+                write(addr, l_addr);
+                pad(l_addr, 1);
+            }
+
+            size_t numTags() const { return 0; }
+            template <typename T, typename... Ts>
+            size_t numTags(const T& t, const Ts&... ts) const { return stream::numTags(t) + numTags(ts...); }
+
+            void writeTags() {}
+            template <typename T, typename... Ts>
+            void writeTags(const T& t, const Ts&... ts) {
+                stream::writeTags(*this, t);
+                writeTags(ts...);
+            }
+
+            void writeArgs() {}
+            template <typename T, typename... Ts>
+            void writeArgs(const T& t, const Ts&... ts) {
+                stream::writeArg(*this, t);
+                writeArgs(ts...);
+            }
         };
 
     }  // namespace message
@@ -75,5 +352,7 @@ namespace osc {
 }  // namespace arduino
 
 using OscEncoder = arduino::osc::message::Encoder;
+template <typename S>
+using OscStreamEncoder = arduino::osc::message::StreamEncoder<S>;
 
 #endif  // ARDUINOOSC_OSCENCODER_H
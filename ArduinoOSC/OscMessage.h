@@ -18,39 +18,111 @@ namespace osc {
         using namespace arx;
 #endif
 
+        // size of the argument at p, or 0 if it does not fit in [p, end)
+        inline size_t argSize(const int type, const char* const p, const char* const end) {
+            if (!p || (p >= end)) {
+                if ((type == TYPE_TAG_TRUE) || (type == TYPE_TAG_FALSE)) return 0;
+                LOG_ERROR(F("storage pointer is out of range"));
+                return 0;
+            }
+
+            size_t sz = 0;
+            switch (type) {
+                case TYPE_TAG_TRUE:
+                case TYPE_TAG_FALSE: {
+                    sz = 0;
+                    break;
+                }
+                case TYPE_TAG_INT32:
+                case TYPE_TAG_FLOAT: {
+                    sz = 4;
+                    break;
+                }
+                case TYPE_TAG_INT64:
+                case TYPE_TAG_DOUBLE: {
+                    sz = 8;
+                    break;
+                }
+                case TYPE_TAG_STRING: {
+                    const char* const q = (const char*)memchr(p, 0, end - p);
+                    if (!q) {
+                        LOG_ERROR(F("string is not terminated"));
+                        return 0;
+                    }
+                    sz = (q - p) + 1;
+                    break;
+                }
+                case TYPE_TAG_BLOB: {
+                    if (end - p < 4) {
+                        LOG_ERROR(F("blob size is out of range"));
+                        return 0;
+                    }
+                    sz = 4 + bytes2pod<uint32_t>(p);
+                    break;
+                }
+                default: {
+                    return 0;
+                    break;
+                }
+            }
+            if ((p + sz > end) ||  // string or blob too large
+                (p + sz < p)       // or even blob so large that it did overflow
+            ) {
+                LOG_ERROR(F("string or blob size is too large"));
+                return 0;
+            }
+
+            return sz;
+        }
+
         class Message {
             TimeTag time_tag; // Used only for the received msg in the bundle
-            String address_str;
-            String type_tags;
+            AddressString address_str;
+            TypeTagString type_tags;
             Storage storage;
             ArgumentQueue arguments;
-            bool valid = false;
 
-            String remote_ip;
-            uint16_t remote_port;
+            // kept in binary, and formatted only when the sender changes
+            uint8_t remote_ip[4] {0, 0, 0, 0};
+            String remote_ip_str {"0.0.0.0"};
+            uint16_t remote_port {0};
+            bool valid = false;
+            bool address_overflow {false};  // the address didn't fit in AddressString (only on NO-STL boards)
 
         public:
             Message() {
                 clear();
             }
-            Message(const String& s, const TimeTag tt = TimeTag::immediate())
-            : time_tag(tt), address_str(s) {
+            Message(const String& s, const TimeTag tt = TimeTag::immediate()) {
+                init(s, tt);
+            }
+            Message(const char* s, const TimeTag tt = TimeTag::immediate()) {
                 init(s, tt);
             }
             Message(const void* ptr, const size_t sz, const TimeTag tt = TimeTag::immediate()) {
-                valid = buildFromRawData(ptr, sz);
-                time_tag = tt;
+                init(ptr, sz, tt);
             }
             Message(const String& ip, const uint16_t port, const String& addr)
-            : remote_ip(ip), remote_port(port) {
+            : remote_port(port) {
                 init(addr);
+                remoteIP(ip);
             }
 
-            virtual ~Message() {}
-
             Message& init(const String& addr, const TimeTag tt = TimeTag::immediate()) {
                 clear();
-                address_str = addr;
+                address_overflow = !address_str.assign(addr.c_str(), addr.length());
+                time_tag = tt;
+                return *this;
+            }
+            Message& init(const char* addr, const TimeTag tt = TimeTag::immediate()) {
+                clear();
+                address_overflow = !address_str.assign(addr, strlen(addr));
+                time_tag = tt;
+                return *this;
+            }
+            // rebuild from the received packet, reusing the buffers of this message
+            Message& init(const void* ptr, const size_t sz, const TimeTag tt) {
+                valid = buildFromRawData(ptr, sz);
                 time_tag = tt;
                 return *this;
             }
@@ -62,26 +134,68 @@ namespace osc {
                     return partialPatternMatch(pattern.c_str(), address_str.c_str());
             }
 
-            void encode(Storage& s, const bool write_size = false) const {
-                size_t l_addr = address_str.length() + 1;
-                size_t l_type = type_tags.length() + 2;
+            // exact number of bytes written by encode()
+            size_t encodedSize(const bool write_size = false) const {
+                return (write_size ? 4 : 0) + ceil4(address_str.length() + 1) + ceil4(type_tags.length() + 2) + storage.size();
+            }
+
+            // append to Storage or BufferStorage, nothing is written if it doesn't fit
+            template <typename S>
+            bool encode(S& s, const bool write_size = false) const {
+                if (address_overflow) {
+                    LOG_ERROR(F("message is not encoded because the address is too long"));
+                    return false;
+                }
+                const size_t sz = encodedSize(false);
+                char* p = s.getBytes(sz + (write_size ? 4 : 0));
+                if (!p) return false;
                 if (write_size) {
-                    uint32_t sz = uint32_t(ceil4(l_addr) + ceil4(l_type) + ceil4(storage.size()));
-                    pod2bytes<uint32_t>(sz, s.getBytes(4));
+                    pod2bytes<uint32_t>((uint32_t)sz, p);
+                    p += 4;
                 }
+                encodeTo(p);
+                return true;
+            }
 
-                strcpy(s.getBytes(l_addr), address_str.c_str());
-                strcpy(s.getBytes(l_type), ("," + type_tags).c_str());
-                if (storage.size())
-                    memcpy(s.getBytes(storage.size()), const_cast<Storage&>(storage).begin(), storage.size());
+            // encode into a caller-supplied buffer
+            // returns the encoded size, or 0 without writing anything if it doesn't fit
+            size_t encode(char* buf, const size_t capacity, const bool write_size = false) const {
+                BufferStorage s(buf, capacity);
+                return encode(s, write_size) ? s.size() : 0;
+            }
+
+            // write encodedSize(false) bytes to p, including the zero padding
+            char* encodeTo(char* p) const {
+                const size_t l_addr = address_str.length() + 1;
+                const size_t l_type = type_tags.length() + 2;
+                memcpy(p, address_str.c_str(), l_addr);
+                memset(p + l_addr, 0, ceil4(l_addr) - l_addr);
+                p += ceil4(l_addr);
+                p[0] = ',';
+                memcpy(p + 1, type_tags.c_str(), l_type - 1);
+                memset(p + l_type, 0, ceil4(l_type) - l_type);
+                p += ceil4(l_type);
+                if (storage.size()) {
+                    memcpy(p, storage.begin(), storage.size());
+                    p += storage.size();
+                }
+                return p;
             }
 
             bool available() const {
                 return valid;
             }
 
+            // true if the address given to init() didn't fit in ARDUINOOSC_MSG_ADDRESS_INLINE_SIZE (only on NO-STL boards)
+            // such a message is not encoded or sent
+            bool overflow() const {
+                return address_overflow;
+            }
+
             void clear() {
-                address_str = type_tags = String("");
+                address_overflow = false;
+                address_str.clear();
+                type_tags.clear();
                 storage.clear();
                 arguments.clear();
                 time_tag = TimeTag::immediate();
@@ -94,10 +208,10 @@ namespace osc {
             // TODO: reference, move....
             template <typename T>
             Message& push(const T& t);
-            Message& push(const char* c) { return pushString(String(c)); }
+            Message& push(const char* c) { return pushString(c); }
 
             Message& pushBool(const bool b) {
-                type_tags += (char)(b ? TYPE_TAG_TRUE : TYPE_TAG_FALSE);
+                if (!type_tags.append((char)(b ? TYPE_TAG_TRUE : TYPE_TAG_FALSE))) return *this;
                 arguments.push_back(std::make_pair(storage.size(), storage.size()));
                 return *this;
             }
@@ -105,15 +219,28 @@ namespace osc {
             Message& pushInt64(const int64_t h) { return pushPod(TYPE_TAG_INT64, h); }
             Message& pushFloat(const float f) { return pushPod(TYPE_TAG_FLOAT, f); }
             Message& pushDouble(const double d) { return pushPod(TYPE_TAG_DOUBLE, d); }
-            Message& pushString(const String& s) {
-                type_tags += (char)TYPE_TAG_STRING;
-                arguments.push_back(std::make_pair(storage.size(), s.length() + 1));
-                strcpy(storage.getBytes(s.length() + 1), s.c_str());
+            Message& pushString(const String& s) { return pushString(s.c_str(), s.length()); }
+            Message& pushString(const char* s) { return pushString(s, strlen(s)); }
+            Message& pushString(const char* s, const size_t len) {
+                if (!type_tags.append((char)TYPE_TAG_STRING)) return *this;
+                arguments.push_back(std::make_pair(storage.size(), len + 1));
+                char* p = storage.getBytes(len + 1);
+                memcpy(p, s, len);
+                p[len] = '\0';
                 return *this;
             }
+            // push n values at once, the type tags and bytes are written in a single pass
+            Message& pushFloats(const float* fs, const size_t n) { return pushPods(TYPE_TAG_FLOAT, fs, n); }
+            Message& pushInt32s(const int32_t* is, const size_t n) { return pushPods(TYPE_TAG_INT32, is, n); }
+            Message& pushDoubles(const double* ds, const size_t n) { return pushPods(TYPE_TAG_DOUBLE, ds, n); }
+            Message& pushInt64s(const int64_t* hs, const size_t n) { return pushPods(TYPE_TAG_INT64, hs, n); }
+#if ARX_HAVE_LIBSTDCPLUSPLUS >= 201103L  // Have libstdc++11
+            Message& push(const std::vector<float>& v) { return pushFloats(v.data(), v.size()); }
+            Message& push(const std::vector<int32_t>& v) { return pushInt32s(v.data(), v.size()); }
+#endif
             Message& pushBlob(const Blob& b) { return pushBlob(b.data(), b.size()); }
             Message& pushBlob(const void* ptr, const size_t num_bytes) {
-                type_tags += (char)TYPE_TAG_BLOB;
+                if (!type_tags.append((char)TYPE_TAG_BLOB)) return *this;
                 arguments.push_back(std::make_pair(storage.size(), num_bytes + 4));
                 pod2bytes<int32_t>((int32_t)num_bytes, storage.getBytes(4));
                 if (num_bytes) memcpy(storage.getBytes(num_bytes), ptr, num_bytes);
@@ -131,12 +258,32 @@ namespace osc {
             int64_t getArgAsInt64(const size_t i) const { return getPod<int64_t>(i); }
             float getArgAsFloat(const size_t i) const { return getPod<float>(i); }
             double getArgAsDouble(const size_t i) const { return getPod<double>(i); }
-            String getArgAsString(const size_t i) const { return String(argBeg(i)); }
+            String getArgAsString(const size_t i) const { return String(getArgAsCStr(i)); }
+            // views refer to the message storage and are valid as long as the message is
+            const char* getArgAsCStr(const size_t i) const {
+                const char* p = argBeg(i);
+                return p ? p : "";
+            }
+            StringView getArgAsStringView(const size_t i) const {
+                const char* p = argBeg(i);
+                return p ? StringView(p, arguments[i].second - 1) : StringView();
+            }
+            BlobView getArgAsBlobView(const size_t i) const {
+                const char* p = argBeg(i);
+                return p ? BlobView(p + 4, arguments[i].second - 4) : BlobView();
+            }
             Blob getArgAsBlob(const size_t i) const {
                 Blob b;
                 b.assign(argBeg(i) + 4, argEnd(i));
                 return b;
             }
+            // copy n arguments from the first-th one, stops at the first argument of another type
+            // returns the number of copied values
+            size_t copyFloats(float* out, const size_t first, const size_t n) const { return copyPods(TYPE_TAG_FLOAT, out, first, n); }
+            size_t copyInt32s(int32_t* out, const size_t first, const size_t n) const { return copyPods(TYPE_TAG_INT32, out, first, n); }
+            size_t copyDoubles(double* out, const size_t first, const size_t n) const { return copyPods(TYPE_TAG_DOUBLE, out, first, n); }
+            size_t copyInt64s(int64_t* out, const size_t first, const size_t n) const { return copyPods(TYPE_TAG_INT64, out, first, n); }
+
             bool getArgAsBool(const size_t i) const {
                 if (getTypeTag(i) == TYPE_TAG_TRUE)
                     return true;
@@ -157,22 +304,42 @@ namespace osc {
             bool isStr(const size_t i) const { return getTypeTag(i) == TYPE_TAG_STRING; }
             bool isBlob(const size_t i) const { return getTypeTag(i) == TYPE_TAG_BLOB; }
 
-            const String& typeTags() const { return type_tags; }
+            // raw argument bytes, following the type tags
+            const char* argsBegin() const { return arguments.empty() ? storage.end() : storage.begin() + arguments[0].first; }
+            const char* argsEnd() const { return storage.end(); }
+
+            String typeTags() const { return String(type_tags.c_str()); }
+            const char* typeTagsCStr() const { return type_tags.c_str(); }
             int getTypeTag(const size_t i) const { return type_tags[i]; }
 
             ///////////////////////////////////////////////////
             // ---------- osc message information ---------- //
             ///////////////////////////////////////////////////
 
-            const String& address() const { return address_str; }
+            String address() const { return String(address_str.c_str()); }
+            const char* addressCStr() const { return address_str.c_str(); }
             size_t size() const { return type_tags.length(); }
 
-            void remoteIP(const String& addr) { remote_ip = addr; }
-            void remoteIP(const IPAddress& addr) { remote_ip = String(addr[0]) + "." + String(addr[1]) + "." + String(addr[2]) + "." + String(addr[3]); }
-            void remoteIP(const char* addr) { remote_ip = String(addr); }
+            void remoteIP(const String& addr) { remoteIP(addr.c_str()); }
+            void remoteIP(const IPAddress& addr) {
+                bool changed = false;
+                for (size_t i = 0; i < 4; ++i) {
+                    changed |= (remote_ip[i] != addr[i]);
+                    remote_ip[i] = addr[i];
+                }
+                if (changed) formatRemoteIP();
+            }
+            void remoteIP(const char* addr) {
+                if (!parseIPv4(addr, remote_ip)) {
+                    LOG_ERROR(F("invalid ip address:"), addr);
+                    memset(remote_ip, 0, sizeof(remote_ip));
+                }
+                formatRemoteIP();
+            }
             void remotePort(const uint16_t p) { remote_port = p; }
 
-            const String& remoteIP() const { return remote_ip; }
+            const String& remoteIP() const { return remote_ip_str; }
+            IPAddress remoteIPAddress() const { return IPAddress(remote_ip[0], remote_ip[1], remote_ip[2], remote_ip[3]); }
             uint16_t remotePort() const { return remote_port; }
 
             TimeTag timeTag() const { return time_tag; }
@@ -182,6 +349,12 @@ namespace osc {
             ////////////////////////////////////////////////
 
         private:
+            void formatRemoteIP() {
+                char buf[16];
+                snprintf(buf, sizeof(buf), "%u.%u.%u.%u", remote_ip[0], remote_ip[1], remote_ip[2], remote_ip[3]);
+                remote_ip_str = buf;
+            }
+
             bool buildFromRawData(const void* ptr, const size_t sz) {
                 clear();
                 storage.assign((const char*)ptr, (const char*)ptr + sz);
@@ -197,11 +370,7 @@ namespace osc {
                     return false;
                 }
 
-                address_str = String("");
-                const char* p = address_beg;
-                while (p != address_end) {
-                    address_str += *p++;
-                };
+                if (!address_str.assign(address_beg, address_end - address_beg)) return false;
 
                 const char* const type_tags_beg = ceil4(address_end + 1 - address_beg) + address_beg;
                 const char* type_tags_end = (const char*)memchr(type_tags_beg, 0, storage.end() - type_tags_beg);
@@ -214,9 +383,8 @@ namespace osc {
                     return false;
                 }
 
-                type_tags = String("");
-                p = type_tags_beg + 1;  // we do not copy the initial ','
-                while (p != type_tags_end) type_tags += *p++;
+                // we do not copy the initial ','
+                type_tags.assign(type_tags_beg + 1, type_tags_end - type_tags_beg - 1);
 
                 const char* arg = ceil4(type_tags_end + 1 - address_beg) + address_beg;
                 size_t iarg = 0;
@@ -258,56 +426,51 @@ namespace osc {
                 return bytes2pod<POD>(argBeg(idx));
             }
 
+            // long and 64-bit integers take both 'i' and 'h'
+            int64_t getInteger(const size_t idx) const {
+                return isInt64(idx) ? getPod<int64_t>(idx) : (int64_t)getPod<int32_t>(idx);
+            }
+
             size_t getArgSize(const int type, const char* const p) const {
                 if ((p < storage.begin()) || (p >= storage.end())) {
                     LOG_ERROR(F("storage pointer is out of range"));
                     return 0;
                 }
+                return argSize(type, p, storage.end());
+            }
 
-                size_t sz = 0;
-                switch (type) {
-                    case TYPE_TAG_TRUE:
-                    case TYPE_TAG_FALSE: {
-                        sz = 0;
-                        break;
-                    }
-                    case TYPE_TAG_INT32:
-                    case TYPE_TAG_FLOAT: {
-                        sz = 4;
-                        break;
-                    }
-                    case TYPE_TAG_INT64:
-                    case TYPE_TAG_DOUBLE: {
-                        sz = 8;
-                        break;
-                    }
-                    case TYPE_TAG_STRING: {
-                        const char* const q = (const char*)memchr(p, 0, storage.end() - p);
-                        sz = (q - p) + 1;
-                        break;
-                    }
-                    case TYPE_TAG_BLOB: {
-                        sz = 4 + bytes2pod<uint32_t>(p);
-                        break;
-                    }
-                    default: {
-                        return 0;
-                        break;
-                    }
-                }
-                if ((p + sz > storage.end()) ||  // string or blob too large
-                    (p + sz < p)                 // or even blob so large that it did overflow
-                ) {
-                    LOG_ERROR(F("string or blob size is too large"));
-                    return 0;
+            template <typename POD>
+            Message& pushPods(const int tag, const POD* vs, const size_t n) {
+                if (n == 0) return *this;
+                char* p = storage.getBytes(n * sizeof(POD));
+                if (!p) return *this;
+                if (!type_tags.append((char)tag, n)) {
+                    storage.data.resize(storage.size() - n * sizeof(POD));
+                    return *this;
                 }
+                const size_t pos = p - storage.begin();
+                arguments.reserve(arguments.size() + n);
+                for (size_t i = 0; i < n; ++i)
+                    arguments.push_back(std::make_pair(pos + i * sizeof(POD), sizeof(POD)));
+                pods2bytes(vs, n, p);
+                return *this;
+            }
 
-                return sz;
+            template <typename POD>
+            size_t copyPods(const int tag, POD* out, const size_t first, const size_t n) const {
+                if (first >= size()) return 0;
+                const size_t last = (first + n < size()) ? (first + n) : size();
+                const char* const tags = type_tags.c_str();
+                size_t cnt = 0;
+                while ((first + cnt < last) && (tags[first + cnt] == tag)) ++cnt;
+                // values of the same type are contiguous in the storage
+                if (cnt) bytes2pods(argBeg(first), cnt, out);
+                return cnt;
             }
 
             template <typename POD>
             Message& pushPod(const int tag, const POD& v) {
-                type_tags += (char)tag;
+                if (!type_tags.append((char)tag)) return *this;
                 arguments.push_back(std::make_pair(storage.size(), sizeof(POD)));
                 pod2bytes(v, storage.getBytes(sizeof(POD)));
                 return *this;
@@ -331,13 +494,13 @@ namespace osc {
         template <>
         inline unsigned Message::arg<unsigned>(const uint8_t i) const { return (unsigned)getPod<int32_t>(i); }
         template <>
-        inline long Message::arg<long>(const uint8_t i) const { return (long)getPod<int32_t>(i); }
+        inline long Message::arg<long>(const uint8_t i) const { return (long)getInteger(i); }
         template <>
-        inline unsigned long Message::arg<unsigned long>(const uint8_t i) const { return (unsigned long)getPod<int32_t>(i); }
+        inline unsigned long Message::arg<unsigned long>(const uint8_t i) const { return (unsigned long)getInteger(i); }
         template <>
-        inline long long Message::arg<long long>(const uint8_t i) const { return (long long)getPod<int64_t>(i); }
+        inline long long Message::arg<long long>(const uint8_t i) const { return (long long)getInteger(i); }
         template <>
-        inline unsigned long long Message::arg<unsigned long long>(const uint8_t i) const { return (unsigned long long)getPod<int64_t>(i); }
+        inline unsigned long long Message::arg<unsigned long long>(const uint8_t i) const { return (unsigned long long)getInteger(i); }
         template <>
         inline float Message::arg<float>(const uint8_t i) const { return getPod<float>(i); }
         template <>
@@ -346,6 +509,20 @@ namespace osc {
         inline String Message::arg<String>(const uint8_t i) const { return getArgAsString(i); }
         template <>
         inline Blob Message::arg<Blob>(const uint8_t i) const { return getArgAsBlob(i); }
+        template <>
+        inline const char* Message::arg<const char*>(const uint8_t i) const { return getArgAsCStr(i); }
+        template <>
+        inline StringView Message::arg<StringView>(const uint8_t i) const { return getArgAsStringView(i); }
+        template <>
+        inline BlobView Message::arg<BlobView>(const uint8_t i) const { return getArgAsBlobView(i); }
+#ifdef ARDUINOOSC_HAVE_STRING_VIEW
+        template <>
+        inline std::string_view Message::arg<std::string_view>(const uint8_t i) const { return getArgAsStringView(i); }
+#endif
+#ifdef ARDUINOOSC_HAVE_SPAN
+        template <>
+        inline std::span<const uint8_t> Message::arg<std::span<const uint8_t>>(const uint8_t i) const { return getArgAsBlobView(i); }
+#endif
 
         template <>
         inline Message& Message::push<bool>(const bool& t) { return pushBool(t); }
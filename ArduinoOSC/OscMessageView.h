@@ -0,0 +1,271 @@
+#pragma once
+
+#ifndef ARDUINOOSC_OSCMESSAGEVIEW_H
+#define ARDUINOOSC_OSCMESSAGEVIEW_H
+
+#include <Arduino.h>
+#include <DebugLog.h>
+#include "OscTypes.h"
+#include "OscUtil.h"
+#include "OscMessage.h"
+
+namespace arduino {
+namespace osc {
+    namespace message {
+
+        // read-only message which refers to the packet buffer directly
+        // the buffer must outlive the view, nothing is copied or allocated
+        class MessageView {
+            TimeTag time_tag;
+            const char* address_beg {nullptr};
+            size_t address_len {0};
+            const char* type_tags_beg {nullptr};  // without the initial ','
+            size_t num_args {0};
+            const char* args_beg {nullptr};
+            const char* data_end {nullptr};
+            bool valid {false};
+
+            // the last resolved argument, so that sequential access is O(1)
+            mutable size_t cursor_idx {0};
+            mutable const char* cursor_ptr {nullptr};
+
+        public:
+            MessageView() {}
+            MessageView(const void* ptr, const size_t sz, const TimeTag tt = TimeTag::immediate()) {
+                init(ptr, sz, tt);
+            }
+
+            bool init(const void* ptr, const size_t sz, const TimeTag tt = TimeTag::immediate()) {
+                clear();
+                time_tag = tt;
+                valid = buildFromRawData((const char*)ptr, sz);
+                return valid;
+            }
+
+            void clear() {
+                time_tag = TimeTag::immediate();
+                address_beg = type_tags_beg = args_beg = data_end = cursor_ptr = nullptr;
+                address_len = num_args = cursor_idx = 0;
+                valid = false;
+            }
+
+            bool available() const { return valid; }
+
+            bool match(const char* pattern, const bool full = true) const {
+                if (!valid) return false;
+                const char* q = internalPatternMatch(pattern, address_beg);
+                return full ? (q && (*q == 0)) : (q != 0);
+            }
+            bool match(const String& pattern, const bool full = true) const {
+                return match(pattern.c_str(), full);
+            }
+
+            ////////////////////////////////////////////
+            // ---------- argument getters ---------- //
+            ////////////////////////////////////////////
+
+            template <typename T>
+            T arg(const uint8_t i) const;
+
+            int32_t getArgAsInt32(const size_t i) const { return getPod<int32_t>(i); }
+            int64_t getArgAsInt64(const size_t i) const { return getPod<int64_t>(i); }
+            float getArgAsFloat(const size_t i) const { return getPod<float>(i); }
+            double getArgAsDouble(const size_t i) const { return getPod<double>(i); }
+            const char* getArgAsString(const size_t i) const {
+                const char* p = argBeg(i);
+                return p ? p : "";
+            }
+            const char* getArgAsCStr(const size_t i) const { return getArgAsString(i); }
+            StringView getArgAsStringView(const size_t i) const {
+                const char* p = argBeg(i);
+                return p ? StringView(p, argSize(TYPE_TAG_STRING, p, data_end) - 1) : StringView();
+            }
+            BlobView getArgAsBlobView(const size_t i) const {
+                const char* p = argBeg(i);
+                return p ? BlobView(p + 4, bytes2pod<uint32_t>(p)) : BlobView();
+            }
+            // copy n arguments from the first-th one, stops at the first argument of another type
+            // returns the number of copied values
+            size_t copyFloats(float* out, const size_t first, const size_t n) const { return copyPods(TYPE_TAG_FLOAT, out, first, n); }
+            size_t copyInt32s(int32_t* out, const size_t first, const size_t n) const { return copyPods(TYPE_TAG_INT32, out, first, n); }
+            size_t copyDoubles(double* out, const size_t first, const size_t n) const { return copyPods(TYPE_TAG_DOUBLE, out, first, n); }
+            size_t copyInt64s(int64_t* out, const size_t first, const size_t n) const { return copyPods(TYPE_TAG_INT64, out, first, n); }
+
+            bool getArgAsBool(const size_t i) const {
+                return getTypeTag(i) == TYPE_TAG_TRUE;
+            }
+
+            //////////////////////////////////////////////////
+            // ---------- argument type checkers ---------- //
+            //////////////////////////////////////////////////
+
+            bool isBool(const size_t i) const { return getTypeTag(i) == TYPE_TAG_TRUE || getTypeTag(i) == TYPE_TAG_FALSE; }
+            bool isInt32(const size_t i) const { return getTypeTag(i) == TYPE_TAG_INT32; }
+            bool isInt64(const size_t i) const { return getTypeTag(i) == TYPE_TAG_INT64; }
+            bool isFloat(const size_t i) const { return getTypeTag(i) == TYPE_TAG_FLOAT; }
+            bool isDouble(const size_t i) const { return getTypeTag(i) == TYPE_TAG_DOUBLE; }
+            bool isStr(const size_t i) const { return getTypeTag(i) == TYPE_TAG_STRING; }
+            bool isBlob(const size_t i) const { return getTypeTag(i) == TYPE_TAG_BLOB; }
+
+            const char* typeTags() const { return type_tags_beg ? type_tags_beg : ""; }
+            int getTypeTag(const size_t i) const { return (i < num_args) ? type_tags_beg[i] : 0; }
+
+            ///////////////////////////////////////////////////
+            // ---------- osc message information ---------- //
+            ///////////////////////////////////////////////////
+
+            const char* address() const { return address_beg ? address_beg : ""; }
+            size_t addressLength() const { return address_len; }
+            size_t size() const { return num_args; }
+
+            TimeTag timeTag() const { return time_tag; }
+
+            // copy into an owning Message, e.g. to keep it after the buffer is released
+            Message toMessage() const {
+                if (!valid) return Message();
+                return Message(address_beg, data_end - address_beg, time_tag);
+            }
+
+        private:
+            bool buildFromRawData(const char* const beg, const size_t sz) {
+                const char* const end = beg + sz;
+                const char* const address_end = (const char*)memchr(beg, 0, sz);
+                if (!address_end) {
+                    LOG_ERROR(F("storage size is too small"));
+                    return false;
+                }
+                if (beg[0] != '/') {
+                    LOG_ERROR(F("first letter of packet must be / but it was"), beg[0]);
+                    return false;
+                }
+
+                const char* const tags = beg + ceil4(address_end + 1 - beg);
+                if (tags >= end) {
+                    LOG_ERROR(F("storage size is too small"));
+                    return false;
+                }
+                const char* const tags_end = (const char*)memchr(tags, 0, end - tags);
+                if (!tags_end) {
+                    LOG_ERROR(F("storage size is too small"));
+                    return false;
+                }
+                if (tags[0] != ',') {
+                    LOG_ERROR(F("first letter of type tag must be \',\' but it was"), tags[0]);
+                    return false;
+                }
+
+                address_beg = beg;
+                address_len = address_end - beg;
+                type_tags_beg = tags + 1;
+                num_args = tags_end - type_tags_beg;
+                args_beg = beg + ceil4(tags_end + 1 - beg);
+                data_end = end;
+                if (args_beg > data_end) args_beg = data_end;
+                cursor_idx = 0;
+                cursor_ptr = args_beg;
+                return true;
+            }
+
+            // walk from the cursor (or from the first argument) to the idx-th argument
+            const char* argBeg(const size_t idx) const {
+                if (idx >= num_args) {
+                    LOG_ERROR(F("index overrun"), idx, F("must be <"), num_args);
+                    return nullptr;
+                }
+                if (!cursor_ptr || (idx < cursor_idx)) {
+                    cursor_idx = 0;
+                    cursor_ptr = args_beg;
+                }
+                while (cursor_idx < idx) {
+                    const int type = type_tags_beg[cursor_idx];
+                    const size_t len = argSize(type, cursor_ptr, data_end);
+                    if ((len == 0) && (type != TYPE_TAG_TRUE) && (type != TYPE_TAG_FALSE)) {
+                        cursor_ptr = nullptr;
+                        return nullptr;
+                    }
+                    cursor_ptr += ceil4(len);
+                    ++cursor_idx;
+                }
+                const int type = type_tags_beg[idx];
+                if ((type != TYPE_TAG_TRUE) && (type != TYPE_TAG_FALSE) && (argSize(type, cursor_ptr, data_end) == 0))
+                    return nullptr;
+                return cursor_ptr;
+            }
+
+            template <typename POD>
+            size_t copyPods(const int tag, POD* out, const size_t first, const size_t n) const {
+                if (first >= num_args) return 0;
+                const size_t last = (first + n < num_args) ? (first + n) : num_args;
+                size_t cnt = 0;
+                while ((first + cnt < last) && (type_tags_beg[first + cnt] == tag)) ++cnt;
+                if (cnt == 0) return 0;
+                const char* const p = argBeg(first);
+                if (!p) return 0;
+                if ((size_t)(data_end - p) < cnt * sizeof(POD)) cnt = (data_end - p) / sizeof(POD);
+                bytes2pods(p, cnt, out);
+                return cnt;
+            }
+
+            template <typename POD>
+            POD getPod(const size_t idx) const {
+                const char* p = argBeg(idx);
+                return p ? bytes2pod<POD>(p) : POD();
+            }
+
+            int64_t getInteger(const size_t idx) const {
+                return isInt64(idx) ? getPod<int64_t>(idx) : (int64_t)getPod<int32_t>(idx);
+            }
+        };
+
+        template <>
+        inline bool MessageView::arg<bool>(const uint8_t i) const { return getArgAsBool(i); }
+        template <>
+        inline char MessageView::arg<char>(const uint8_t i) const { return (char)getPod<int32_t>(i); }
+        template <>
+        inline signed char MessageView::arg<signed char>(const uint8_t i) const { return (signed char)getPod<int32_t>(i); }
+        template <>
+        inline unsigned char MessageView::arg<unsigned char>(const uint8_t i) const { return (unsigned char)getPod<int32_t>(i); }
+        template <>
+        inline short MessageView::arg<short>(const uint8_t i) const { return (short)getPod<int32_t>(i); }
+        template <>
+        inline unsigned short MessageView::arg<unsigned short>(const uint8_t i) const { return (unsigned short)getPod<int32_t>(i); }
+        template <>
+        inline int MessageView::arg<int>(const uint8_t i) const { return (int)getPod<int32_t>(i); }
+        template <>
+        inline unsigned MessageView::arg<unsigned>(const uint8_t i) const { return (unsigned)getPod<int32_t>(i); }
+        template <>
+        inline long MessageView::arg<long>(const uint8_t i) const { return (long)getInteger(i); }
+        template <>
+        inline unsigned long MessageView::arg<unsigned long>(const uint8_t i) const { return (unsigned long)getInteger(i); }
+        template <>
+        inline long long MessageView::arg<long long>(const uint8_t i) const { return (long long)getInteger(i); }
+        template <>
+        inline unsigned long long MessageView::arg<unsigned long long>(const uint8_t i) const { return (unsigned long long)getInteger(i); }
+        template <>
+        inline float MessageView::arg<float>(const uint8_t i) const { return getPod<float>(i); }
+        template <>
+        inline double MessageView::arg<double>(const uint8_t i) const { return getPod<double>(i); }
+        template <>
+        inline const char* MessageView::arg<const char*>(const uint8_t i) const { return getArgAsString(i); }
+        template <>
+        inline String MessageView::arg<String>(const uint8_t i) const { return String(getArgAsString(i)); }
+        template <>
+        inline StringView MessageView::arg<StringView>(const uint8_t i) const { return getArgAsStringView(i); }
+        template <>
+        inline BlobView MessageView::arg<BlobView>(const uint8_t i) const { return getArgAsBlobView(i); }
+#ifdef ARDUINOOSC_HAVE_STRING_VIEW
+        template <>
+        inline std::string_view MessageView::arg<std::string_view>(const uint8_t i) const { return getArgAsStringView(i); }
+#endif
+#ifdef ARDUINOOSC_HAVE_SPAN
+        template <>
+        inline std::span<const uint8_t> MessageView::arg<std::span<const uint8_t>>(const uint8_t i) const { return getArgAsBlobView(i); }
+#endif
+
+    }  // namespace message
+}  // namespace osc
+}  // namespace arduino
+
+using OscMessageView = arduino::osc::message::MessageView;
+
+#endif  // ARDUINOOSC_OSCMESSAGEVIEW_H
@@ -0,0 +1,196 @@
+#pragma once
+
+#ifndef ARDUINOOSC_OSCMETHODTREE_H
+#define ARDUINOOSC_OSCMETHODTREE_H
+
+#include <Arduino.h>
+#include <DebugLog.h>
+#include "OscTypes.h"
+#include "OscUtil.h"
+
+#ifndef ARDUINOOSC_DISABLE_METHOD_TREE
+
+namespace arduino {
+namespace osc {
+    namespace server {
+
+        struct MethodNode {
+            String name;  // a part of the address between '/'
+            element::Base* elem {nullptr};
+            uint32_t child {UINT32_MAX};    // first child
+            uint32_t sibling {UINT32_MAX};  // next child of the parent
+            mutable uint32_t reported {0};  // last walk which reported the method
+            mutable uint32_t entered {0};   // last walk which entered the node by '//'
+            mutable uint32_t any_mask {0};  // '//' parts of the pattern which entered the node in the walk
+        };
+
+        struct MethodWalkState {
+            uint32_t node;
+            const char* part;  // the rest of the pattern, starts with '/' if it's a '//'
+            uint8_t anys;      // number of '//' passed
+        };
+
+        // plain subscribed addresses (methods) in a tree of their parts, as in the OSC 1.0 address space
+        // an incoming address pattern is expanded by walking only the branches which match it part by part,
+        // so the cost depends on the matched methods and their siblings, not on all the subscriptions
+        // each part of the pattern is matched with fullPatternMatch() (so '{}' can't contain '/'),
+        // and '//' matches any number of levels
+        class MethodTree {
+#if ARX_HAVE_LIBSTDCPLUSPLUS >= 201103L  // Have libstdc++11
+            static constexpr size_t MAX_NODES = SIZE_MAX;
+#else
+            static constexpr size_t MAX_NODES = ARDUINOOSC_MAX_METHOD_TREE_NODES;
+#endif
+
+            MethodNodes nodes;
+            mutable MethodWalk walk;
+            mutable uint32_t generation {0};
+
+        public:
+            // the root is added by the first add(), so an unused tree allocates nothing
+            void clear() {
+                nodes.clear();
+                generation = 0;
+            }
+
+            size_t numNodes() const { return nodes.size(); }
+
+            // returns false if the address is not a method (a pattern or no leading '/')
+            // or the tree is full
+            bool add(const char* addr, element::Base* elem) {
+                if ((addr[0] != '/') || isAddressPattern(addr)) return false;
+                if (nodes.empty()) nodes.push_back(MethodNode());
+                uint32_t n = 0;
+                const char* p = addr + 1;
+                while (true) {
+                    const char* end = strchr(p, '/');
+                    if (!end) end = p + strlen(p);
+                    n = child(n, p, end - p);
+                    if (n == UINT32_MAX) {
+                        LOG_ERROR(F("method tree is full:"), addr);
+                        return false;
+                    }
+                    if (!*end) break;
+                    p = end + 1;
+                }
+                nodes[n].elem = elem;
+                return true;
+            }
+
+            // call f(element::Base*) once for each method which matches the pattern
+            template <typename F>
+            void match(const char* pattern, F&& f) const {
+                if ((pattern[0] != '/') || (nodes.size() <= 1)) return;
+                nextGeneration();
+                walk.clear();
+                push(0, pattern + 1, 0);
+                char buf[ARDUINOOSC_PATTERN_MATCH_MAX_LENGTH + 1];
+                while (!walk.empty()) {
+                    const MethodWalkState s = walk.back();
+                    walk.pop_back();
+
+                    if (*s.part == '/') {
+                        // '//': go on with the next part here, or one more level down
+                        const MethodNode& node = nodes[s.node];
+                        if (node.entered != generation) {
+                            node.entered = generation;
+                            node.any_mask = 0;
+                        }
+                        const uint32_t bit = (s.anys < 32) ? (1UL << s.anys) : 0;
+                        if (bit && (node.any_mask & bit)) continue;  // already entered in the same way
+                        node.any_mask |= bit;
+                        const char* next = s.part;
+                        while (*next == '/') ++next;
+                        push(s.node, next, (s.anys < 32) ? (s.anys + 1) : s.anys);
+                        for (uint32_t c = node.child; c != UINT32_MAX; c = nodes[c].sibling)
+                            push(c, s.part, s.anys);
+                        continue;
+                    }
+
+                    const char* end = strchr(s.part, '/');
+                    if (!end) end = s.part + strlen(s.part);
+                    const size_t len = end - s.part;
+                    bool wildcard = false;
+                    for (const char* p = s.part; p < end; ++p) {
+                        if ((*p == '?') || (*p == '*') || (*p == '[') || (*p == '{')) wildcard = true;
+                    }
+                    const bool any = (len == 1) && (*s.part == '*');  // the most common one matches all children
+                    if (wildcard && !any) {
+                        if (len > ARDUINOOSC_PATTERN_MATCH_MAX_LENGTH) {
+                            LOG_ERROR(F("pattern is too long:"), pattern);
+                            continue;
+                        }
+                        memcpy(buf, s.part, len);
+                        buf[len] = '\0';
+                    }
+
+                    for (uint32_t c = nodes[s.node].child; c != UINT32_MAX; c = nodes[c].sibling) {
+                        const MethodNode& node = nodes[c];
+                        if (any) {
+                            // no need to match
+                        } else if (wildcard) {
+                            if (!fullPatternMatch(buf, node.name.c_str())) continue;
+                        } else if ((node.name.length() != len) || (memcmp(node.name.c_str(), s.part, len) != 0)) {
+                            continue;
+                        }
+                        if (*end)
+                            push(c, end + 1, s.anys);
+                        else
+                            report(c, f);
+                    }
+                }
+            }
+
+        private:
+            uint32_t child(const uint32_t parent, const char* name, const size_t len) {
+                uint32_t* link = &nodes[parent].child;
+                while (*link != UINT32_MAX) {
+                    const MethodNode& node = nodes[*link];
+                    if ((node.name.length() == len) && (memcmp(node.name.c_str(), name, len) == 0)) return *link;
+                    link = &nodes[*link].sibling;
+                }
+                if (nodes.size() >= MAX_NODES) return UINT32_MAX;
+                const uint32_t n = (uint32_t)nodes.size();
+                nodes.push_back(MethodNode());
+                nodes.back().name.reserve(len);
+                for (size_t i = 0; i < len; ++i) nodes.back().name += name[i];
+                // the link may be moved by push_back()
+                link = &nodes[parent].child;
+                while (*link != UINT32_MAX) link = &nodes[*link].sibling;
+                *link = n;
+                return n;
+            }
+
+            void push(const uint32_t node, const char* part, const uint8_t anys) const {
+                if (walk.size() >= MAX_NODES) {
+                    LOG_ERROR(F("method tree walk overflow"));
+                    return;
+                }
+                walk.push_back(MethodWalkState {node, part, anys});
+            }
+
+            template <typename F>
+            void report(const uint32_t n, F& f) const {
+                const MethodNode& node = nodes[n];
+                if (!node.elem || (node.reported == generation)) return;
+                node.reported = generation;
+                f(node.elem);
+            }
+
+            void nextGeneration() const {
+                if (++generation == 0) {
+                    for (auto& n : nodes) n.reported = n.entered = 0;
+                    generation = 1;
+                }
+            }
+        };
+
+    }  // namespace server
+}  // namespace osc
+}  // namespace arduino
+
+using OscMethodTree = arduino::osc::server::MethodTree;
+
+#endif  // ARDUINOOSC_DISABLE_METHOD_TREE
+
+#endif  // ARDUINOOSC_OSCMETHODTREE_H
@@ -0,0 +1,274 @@
+#pragma once
+
+#ifndef ARDUINOOSC_OSCPATTERNAUTOMATON_H
+#define ARDUINOOSC_OSCPATTERNAUTOMATON_H
+
+#include <Arduino.h>
+#include <ArxTypeTraits.h>
+#include "OscUtil.h"
+
+#if ARX_HAVE_LIBSTDCPLUSPLUS >= 201103L  // Have libstdc++11
+
+#include <vector>
+
+namespace arduino {
+namespace osc {
+
+    // union of address patterns compiled into one NFA (a trie of pattern elements)
+    // an address is matched against all the patterns in one pass with no backtracking,
+    // and the results are the same as fullPatternMatch()
+    // patterns which can't be compiled with the same semantics are rejected by add(),
+    // so that the caller can match them with fullPatternMatch() instead
+    class PatternAutomaton {
+        enum : uint8_t {
+            LOOP_NONE,
+            LOOP_SEGMENT,  // '*', any characters except '/'
+            LOOP_ANY,      // before the '/' of '//', any characters
+        };
+        enum : uint8_t {
+            EDGE_CHAR,
+            EDGE_ANY,    // '?'
+            EDGE_CLASS,  // '[...]'
+        };
+
+        struct Edge {
+            uint8_t kind;
+            char c;
+            uint32_t cls;
+            uint32_t to;
+        };
+        struct Node {
+            uint8_t loop {LOOP_NONE};
+            std::vector<Edge> edges;
+            std::vector<uint32_t> loops;  // children entered without consuming a character
+            std::vector<uint32_t> accepts;
+        };
+        struct CharClass {
+            String src;
+            bool reverse;
+            std::vector<std::pair<char, char>> ranges;
+        };
+        // an element of a pattern
+        struct Element {
+            uint8_t loop;  // if not LOOP_NONE, the element is a loop
+            uint8_t kind;
+            char c;
+            uint32_t cls;
+        };
+
+        static constexpr size_t MAX_EXPANSIONS = 64;
+
+        std::vector<Node> nodes;
+        std::vector<CharClass> classes;
+        mutable std::vector<uint32_t> stamps;
+        mutable std::vector<uint32_t> id_stamps;  // to report an id once even if it's accepted by some states
+        mutable std::vector<uint32_t> curr, next;
+        mutable uint32_t generation {0};
+
+    public:
+        PatternAutomaton() { clear(); }
+
+        void clear() {
+            nodes.clear();
+            nodes.emplace_back();
+            classes.clear();
+            stamps.assign(1, 0);
+            id_stamps.clear();
+            generation = 0;
+        }
+
+        size_t numStates() const { return nodes.size(); }
+
+        // compile the pattern, matched addresses are reported with the id
+        // returns false if the pattern can't be compiled with the same semantics as fullPatternMatch()
+        bool add(const char* pattern, const uint32_t id) {
+            std::vector<std::vector<Element>> seqs(1);
+            if (!parse(pattern, seqs)) return false;
+            for (auto& seq : seqs) insert(seq, id);
+            stamps.assign(nodes.size(), 0);
+            if (id_stamps.size() <= id) id_stamps.resize(id + 1);
+            for (auto& s : id_stamps) s = 0;
+            generation = 0;
+            return true;
+        }
+
+        // call f(id) for every pattern which fully matches the address
+        template <typename F>
+        void match(const char* addr, F&& f) const {
+            curr.clear();
+            nextGeneration();
+            enter(0, curr);
+            for (const char* p = addr; *p && !curr.empty(); ++p) {
+                const char c = *p;
+                next.clear();
+                nextGeneration();
+                for (const uint32_t n : curr) {
+                    const Node& node = nodes[n];
+                    if ((node.loop == LOOP_ANY) || ((node.loop == LOOP_SEGMENT) && (c != '/'))) enter(n, next);
+                    for (const Edge& e : node.edges) {
+                        if (accept(e, c)) enter(e.to, next);
+                    }
+                }
+                curr.swap(next);
+            }
+            nextGeneration();
+            for (const uint32_t n : curr) {
+                for (const uint32_t id : nodes[n].accepts) {
+                    if (id_stamps[id] == generation) continue;
+                    id_stamps[id] = generation;
+                    f(id);
+                }
+            }
+        }
+
+    private:
+        void nextGeneration() const {
+            if (++generation == 0) {
+                for (auto& s : stamps) s = 0;
+                for (auto& s : id_stamps) s = 0;
+                generation = 1;
+            }
+        }
+
+        void enter(const uint32_t n, std::vector<uint32_t>& states) const {
+            if (stamps[n] == generation) return;
+            stamps[n] = generation;
+            states.push_back(n);
+            for (const uint32_t l : nodes[n].loops) enter(l, states);
+        }
+
+        bool accept(const Edge& e, const char c) const {
+            if (e.kind == EDGE_CHAR) return e.c == c;
+            if (e.kind == EDGE_ANY) return true;
+            const CharClass& cls = classes[e.cls];
+            bool match = cls.reverse;
+            for (auto& r : cls.ranges) {
+                if ((c >= r.first) && (c <= r.second)) match = !cls.reverse;
+            }
+            return match;
+        }
+
+        void append(std::vector<std::vector<Element>>& seqs, const Element& e) {
+            for (auto& s : seqs) s.push_back(e);
+        }
+
+        // parse in the same way as internalPatternMatch()
+        bool parse(const char* p, std::vector<std::vector<Element>>& seqs) {
+            while (*p) {
+                if (*p == '?') {
+                    append(seqs, Element {LOOP_NONE, EDGE_ANY, 0, 0});
+                    ++p;
+                } else if (*p == '[') {
+                    const char* const beg = p;
+                    ++p;
+                    CharClass cls;
+                    cls.reverse = false;
+                    if (*p == '!') {
+                        cls.reverse = true;
+                        ++p;
+                    }
+                    for (; *p && (*p != ']'); ++p) {
+                        char c0 = *p, c1 = c0;
+                        if ((p[1] == '-') && p[2]) {
+                            p += 2;
+                            c1 = *p;
+                        }
+                        cls.ranges.emplace_back(c0, c1);
+                    }
+                    if (*p != ']') return false;  // never matches
+                    ++p;
+                    cls.src = String(beg).substring(0, p - beg);
+                    append(seqs, Element {LOOP_NONE, EDGE_CLASS, 0, addClass(cls)});
+                } else if (*p == '*') {
+                    while (*p == '*') ++p;
+                    append(seqs, Element {LOOP_SEGMENT, EDGE_ANY, 0, 0});
+                } else if ((*p == '/') && (p[1] == '/')) {
+                    while (p[1] == '/') ++p;
+                    append(seqs, Element {LOOP_ANY, EDGE_ANY, 0, 0});
+                    append(seqs, Element {LOOP_NONE, EDGE_CHAR, '/', 0});
+                    ++p;
+                } else if (*p == '{') {
+                    const char* const end = strchr(p, '}');
+                    if (!end) return false;  // never matches
+                    // the first alternative which is a prefix of the address is taken without backtracking
+                    // it's the same as the alternation only if no alternative is a prefix of another one
+                    std::vector<String> alts;
+                    const char* q = p + 1;
+                    while (true) {
+                        const char* comma = strchr(q, ',');
+                        if (!comma || (comma > end)) comma = end;
+                        alts.push_back(String(q).substring(0, comma - q));
+                        if (comma == end) break;
+                        q = comma + 1;
+                    }
+                    for (size_t i = 0; i < alts.size(); ++i) {
+                        for (size_t j = 0; j < alts.size(); ++j) {
+                            if ((i != j) && alts[j].startsWith(alts[i])) return false;
+                        }
+                    }
+                    if (seqs.size() * alts.size() > MAX_EXPANSIONS) return false;
+                    std::vector<std::vector<Element>> expanded;
+                    for (auto& s : seqs) {
+                        for (auto& a : alts) {
+                            expanded.push_back(s);
+                            for (size_t i = 0; i < a.length(); ++i)
+                                expanded.back().push_back(Element {LOOP_NONE, EDGE_CHAR, a[i], 0});
+                        }
+                    }
+                    seqs.swap(expanded);
+                    p = end + 1;
+                } else {
+                    append(seqs, Element {LOOP_NONE, EDGE_CHAR, *p, 0});
+                    ++p;
+                }
+            }
+            return true;
+        }
+
+        uint32_t addClass(const CharClass& cls) {
+            for (size_t i = 0; i < classes.size(); ++i)
+                if (classes[i].src == cls.src) return (uint32_t)i;
+            classes.push_back(cls);
+            return (uint32_t)(classes.size() - 1);
+        }
+
+        void insert(const std::vector<Element>& seq, const uint32_t id) {
+            uint32_t n = 0;
+            for (const Element& e : seq) {
+                uint32_t child = UINT32_MAX;
+                if (e.loop != LOOP_NONE) {
+                    for (const uint32_t l : nodes[n].loops)
+                        if (nodes[l].loop == e.loop) child = l;
+                    if (child == UINT32_MAX) {
+                        child = (uint32_t)nodes.size();
+                        nodes.emplace_back();
+                        nodes[child].loop = e.loop;
+                        nodes[n].loops.push_back(child);
+                    }
+                } else {
+                    for (const Edge& edge : nodes[n].edges) {
+                        if ((edge.kind == e.kind) && (edge.c == e.c) && (edge.cls == e.cls)) child = edge.to;
+                    }
+                    if (child == UINT32_MAX) {
+                        child = (uint32_t)nodes.size();
+                        nodes.emplace_back();
+                        nodes[n].edges.push_back(Edge {e.kind, e.c, e.cls, child});
+                    }
+                }
+                n = child;
+            }
+            auto& accepts = nodes[n].accepts;
+            for (const uint32_t a : accepts)
+                if (a == id) return;
+            accepts.push_back(id);
+        }
+    };
+
+}  // namespace osc
+}  // namespace arduino
+
+using OscPatternAutomaton = arduino::osc::PatternAutomaton;
+
+#endif  // Have libstdc++11
+
+#endif  // ARDUINOOSC_OSCPATTERNAUTOMATON_H
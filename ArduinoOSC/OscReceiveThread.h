@@ -0,0 +1,246 @@
+#pragma once
+
+#ifndef ARDUINOOSC_OSCRECEIVETHREAD_H
+#define ARDUINOOSC_OSCRECEIVETHREAD_H
+
+#include <Arduino.h>
+#include <DebugLog.h>
+#include "OscTypes.h"
+#include "OscMessage.h"
+#include "OscDecoder.h"
+
+#ifdef ARDUINOOSC_HAVE_THREAD
+
+#include <chrono>
+#include <memory>
+#include <vector>
+#if defined(ESP_PLATFORM)
+#include <esp_pthread.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#ifndef ARDUINOOSC_RECEIVE_QUEUE_SIZE
+#define ARDUINOOSC_RECEIVE_QUEUE_SIZE 64  // rounded up to a power of two
+#endif
+#ifndef ARDUINOOSC_RECEIVE_POLL_INTERVAL_US
+#if defined(ESP_PLATFORM)
+#define ARDUINOOSC_RECEIVE_POLL_INTERVAL_US 1000  // at least one tick, see ReceiveThread::idle()
+#else
+#define ARDUINOOSC_RECEIVE_POLL_INTERVAL_US 100  // sleep of the receive thread while no packet arrives
+#endif
+#endif
+
+namespace arduino {
+namespace osc {
+    namespace server {
+
+        using namespace message;
+
+        // bounded single-producer / single-consumer queue of decoded messages without locks
+        // the slots are allocated by resize() and the messages in them are reused
+        class MessageRing {
+            std::vector<Message> slots;
+            size_t mask {0};
+            // the indices only grow, and are on separate cache lines not to be shared by both threads
+            std::atomic<size_t> head {0};  // written by the producer
+            char pad_head[64 - sizeof(std::atomic<size_t>)];
+            std::atomic<size_t> tail {0};  // written by the consumer
+            char pad_tail[64 - sizeof(std::atomic<size_t>)];
+
+        public:
+            // must not be called while the threads use the ring
+            void resize(const size_t n) {
+                size_t sz = 1;
+                while (sz < n) sz *= 2;
+                slots.clear();
+                slots.resize(sz);
+                mask = sz - 1;
+                head.store(0, std::memory_order_relaxed);
+                tail.store(0, std::memory_order_relaxed);
+            }
+
+            size_t capacity() const { return slots.size(); }
+            size_t size() const {
+                const size_t t = tail.load(std::memory_order_acquire);
+                return head.load(std::memory_order_acquire) - t;
+            }
+            bool empty() const { return size() == 0; }
+
+            // producer: the slot to be written next, or nullptr if the ring is full
+            Message* back() {
+                const size_t h = head.load(std::memory_order_relaxed);
+                if (h - tail.load(std::memory_order_acquire) >= slots.size()) return nullptr;
+                return &slots[h & mask];
+            }
+            // producer: publish the slot written after back()
+            void push() { head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+            // consumer: the oldest message, or nullptr if the ring is empty
+            Message* front() {
+                const size_t t = tail.load(std::memory_order_relaxed);
+                if (t == head.load(std::memory_order_acquire)) return nullptr;
+                return &slots[t & mask];
+            }
+            // consumer: give the slot of front() back to the producer
+            void pop() { tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+        };
+
+        struct ReceiveStats {
+            uint32_t packets {0};    // received packets
+            uint32_t messages {0};   // messages queued
+            uint32_t dropped {0};    // messages dropped because the queue was full
+            uint32_t oversized {0};  // packets discarded because of maxPacketSize()
+            uint32_t errors {0};     // messages which failed to be decoded
+            size_t depth {0};        // messages in the queue now
+            size_t max_depth {0};
+        };
+
+        // reads and decodes the packets of a port in its own thread, and queues the messages
+        // for the application thread, which dispatches them from Server::parse()
+        // the udp of the port must not be used by the other threads while it runs
+        template <typename S>
+        class ReceiveThread {
+            UdpRef<S> stream;
+            MessageRing ring;
+            std::thread th;
+            std::atomic<bool> running {false};
+            size_t max_packet_size {ARDUINOOSC_MAX_RECV_PACKET_SIZE};
+
+            // used only by the receive thread
+            PacketBuffer packet_buf;
+            BundleWalker walker;
+
+            std::atomic<uint32_t> num_packets {0};
+            std::atomic<uint32_t> num_messages {0};
+            std::atomic<uint32_t> num_dropped {0};
+            std::atomic<uint32_t> num_oversized {0};
+            std::atomic<uint32_t> num_errors {0};
+            std::atomic<size_t> max_depth {0};
+
+        public:
+            ~ReceiveThread() { stop(); }
+
+            // core < 0 leaves the thread to the scheduler of the OS
+            bool start(const UdpRef<S>& s, const size_t queue_size, const size_t max_size, const int core = -1) {
+                if (running.load()) return false;
+                stream = s;
+                max_packet_size = max_size;
+                ring.resize(queue_size);
+                running.store(true);
+#if defined(ESP_PLATFORM)
+                esp_pthread_cfg_t cfg = esp_pthread_get_default_config();
+                if (core >= 0) cfg.pin_to_core = core;
+                esp_pthread_set_cfg(&cfg);
+                th = std::thread([this] { run(); });
+                cfg = esp_pthread_get_default_config();
+                esp_pthread_set_cfg(&cfg);
+#else
+                th = std::thread([this] { run(); });
+#if defined(__linux__)
+                if (core >= 0) {
+                    cpu_set_t set;
+                    CPU_ZERO(&set);
+                    CPU_SET(core, &set);
+                    if (pthread_setaffinity_np(th.native_handle(), sizeof(set), &set) != 0)
+                        LOG_ERROR(F("failed to pin the receive thread to core"), core);
+                }
+#else
+                if (core >= 0) LOG_ERROR(F("pinning the receive thread to a core is not supported"));
+#endif
+#endif
+                return true;
+            }
+
+            // the queued messages are discarded
+            void stop() {
+                if (!running.exchange(false)) return;
+                if (th.joinable()) th.join();
+                ring.resize(ring.capacity());
+            }
+
+            bool isRunning() const { return running.load(); }
+            MessageRing& queue() { return ring; }
+
+            ReceiveStats stats() const {
+                ReceiveStats s;
+                s.packets = num_packets.load(std::memory_order_relaxed);
+                s.messages = num_messages.load(std::memory_order_relaxed);
+                s.dropped = num_dropped.load(std::memory_order_relaxed);
+                s.oversized = num_oversized.load(std::memory_order_relaxed);
+                s.errors = num_errors.load(std::memory_order_relaxed);
+                s.depth = ring.size();
+                s.max_depth = max_depth.load(std::memory_order_relaxed);
+                return s;
+            }
+
+        private:
+            void run() {
+                while (running.load(std::memory_order_relaxed)) {
+                    if (!receive()) idle();
+                }
+            }
+
+            void idle() {
+#if defined(ESP_PLATFORM)
+                // sleep_for() shorter than a tick busy-waits in usleep() and starves the other tasks on the core
+                const TickType_t ticks = pdMS_TO_TICKS(ARDUINOOSC_RECEIVE_POLL_INTERVAL_US / 1000);
+                vTaskDelay(ticks ? ticks : 1);
+#else
+                std::this_thread::sleep_for(std::chrono::microseconds(ARDUINOOSC_RECEIVE_POLL_INTERVAL_US));
+#endif
+            }
+
+            // returns false if there was no packet
+            bool receive() {
+                const size_t size = stream->parsePacket();
+                if (size == 0) return false;
+
+                num_packets.fetch_add(1, std::memory_order_relaxed);
+                if (size > max_packet_size) {
+                    num_oversized.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+                if (packet_buf.size() < size) packet_buf.resize(size);
+                const size_t n = stream->read(&packet_buf.front(), size);
+                if (n > size) return true;  // read() failed (-1)
+
+                walker.init(&packet_buf.front(), n);
+                const char* beg;
+                size_t sz;
+                TimeTag tt;
+                while (walker.next(beg, sz, tt)) {
+                    Message* m = ring.back();
+                    if (!m) {
+                        num_dropped.fetch_add(1, std::memory_order_relaxed);
+                        continue;
+                    }
+                    m->init(beg, sz, tt);
+                    if (!m->available()) {
+                        num_errors.fetch_add(1, std::memory_order_relaxed);
+                        continue;
+                    }
+                    m->remoteIP(stream->S::remoteIP());
+                    m->remotePort((uint16_t)stream->S::remotePort());
+                    ring.push();
+                    num_messages.fetch_add(1, std::memory_order_relaxed);
+                    const size_t depth = ring.size();
+                    if (depth > max_depth.load(std::memory_order_relaxed)) max_depth.store(depth, std::memory_order_relaxed);
+                }
+                return true;
+            }
+        };
+
+    }  // namespace server
+}  // namespace osc
+}  // namespace arduino
+
+using OscMessageRing = arduino::osc::server::MessageRing;
+using OscReceiveStats = arduino::osc::server::ReceiveStats;
+
+#endif  // ARDUINOOSC_HAVE_THREAD
+
+#endif  // ARDUINOOSC_OSCRECEIVETHREAD_H
@@ -0,0 +1,203 @@
+#pragma once
+
+#ifndef ARDUINOOSC_OSCSCHEDULER_H
+#define ARDUINOOSC_OSCSCHEDULER_H
+
+#include <Arduino.h>
+#include <DebugLog.h>
+#include "OscTypes.h"
+#include "OscMessage.h"
+
+#ifndef ARDUINOOSC_DISABLE_BUNDLE
+
+namespace arduino {
+namespace osc {
+    namespace server {
+
+        using namespace message;
+
+        // what to do with a message whose time tag has already passed when it arrives
+        enum class LatePolicy : uint8_t {
+            RUN_NOW,  // dispatch it right away
+            DROP,     // discard it
+        };
+
+        struct ScheduledEntry {
+            uint64_t time;
+            uint32_t seq;  // keeps the arrival order of the messages with the same time tag
+            size_t slot;
+        };
+
+        // holds messages with a future time tag in a min-heap until their time comes
+        // it is enabled by giving a clock which returns the current time as an NTP time tag
+        class Scheduler {
+        public:
+            using Clock = uint64_t (*)();
+
+            struct Stats {
+                uint32_t scheduled {0};   // messages held for the future
+                uint32_t dispatched {0};  // scheduled messages dispatched
+                uint32_t late {0};        // messages whose time tag had passed on arrival
+                uint32_t dropped {0};     // late messages dropped by LatePolicy::DROP
+                uint32_t overflowed {0};  // messages dispatched right away because the queue was full
+                uint32_t max_delay_us {0};  // max delay of the dispatch from the time tag
+            };
+
+        private:
+#ifndef ARDUINOOSC_DISABLE_SCHEDULER
+            ScheduledMessages messages;
+            ScheduledHeap heap;
+            ScheduledSlots free_slots;
+#endif
+            Clock clock_func {nullptr};
+            LatePolicy late_policy {LatePolicy::RUN_NOW};
+            uint32_t seq {0};
+            Stats stat;
+
+        public:
+            void clock(const Clock c) {
+#ifdef ARDUINOOSC_DISABLE_SCHEDULER
+                // without the queue every message is dispatched on arrival
+                if (c) LOG_ERROR(F("scheduler is disabled, define ARDUINOOSC_MAX_SCHEDULED_MSG_SIZE to use it"));
+#else
+                clock_func = c;
+#endif
+            }
+            Clock clock() const { return clock_func; }
+            void latePolicy(const LatePolicy p) { late_policy = p; }
+            LatePolicy latePolicy() const { return late_policy; }
+
+            bool enabled() const { return clock_func != nullptr; }
+            const Stats& stats() const { return stat; }
+            void resetStats() { stat = Stats(); }
+
+#ifdef ARDUINOOSC_DISABLE_SCHEDULER
+            size_t size() const { return 0; }
+            void clear() {}
+            bool take(const Message&) { return false; }
+            template <typename F>
+            size_t dispatch(F&&) { return 0; }
+#else
+            size_t size() const { return heap.size(); }
+
+            void clear() {
+                heap.clear();
+                free_slots.clear();
+                for (size_t i = 0; i < messages.size(); ++i) free_slots.push_back(i);
+            }
+
+            // returns true if the message was scheduled or dropped,
+            // or false if it should be dispatched right away
+            bool take(const Message& m) {
+                const uint64_t tt = m.timeTag();
+                if (!enabled() || (tt == TimeTag::immediate())) return false;
+
+                const uint64_t now = clock_func();
+                if (tt <= now) {
+                    ++stat.late;
+                    if (late_policy == LatePolicy::DROP) {
+                        ++stat.dropped;
+                        return true;
+                    }
+                    return false;
+                }
+
+                const size_t slot = acquire();
+                if (slot == SIZE_MAX) {
+                    LOG_ERROR(F("scheduler queue overflow"));
+                    ++stat.overflowed;
+                    return false;
+                }
+                messages[slot] = m;
+                heap.push_back(ScheduledEntry {tt, seq++, slot});
+                siftUp(heap.size() - 1);
+                ++stat.scheduled;
+                return true;
+            }
+
+            // call f(Message&) for all messages whose time has come, in time tag order
+            template <typename F>
+            size_t dispatch(F&& f) {
+                if (!enabled() || heap.empty()) return 0;
+                const uint64_t now = clock_func();
+                size_t n = 0;
+                while (!heap.empty() && (heap[0].time <= now)) {
+                    const ScheduledEntry e = heap[0];
+                    heap[0] = heap.back();
+                    heap.pop_back();
+                    if (!heap.empty()) siftDown(0);
+
+                    const uint32_t delay_us = toMicros(now - e.time);
+                    if (delay_us > stat.max_delay_us) stat.max_delay_us = delay_us;
+                    ++stat.dispatched;
+                    ++n;
+                    f(messages[e.slot]);
+                    free_slots.push_back(e.slot);
+                }
+                return n;
+            }
+
+        private:
+            size_t acquire() {
+                if (!free_slots.empty()) {
+                    const size_t slot = free_slots.back();
+                    free_slots.pop_back();
+                    return slot;
+                }
+                if (messages.size() >= ARDUINOOSC_MAX_SCHEDULED_MSG_SIZE) return SIZE_MAX;
+                messages.push_back(Message());
+                return messages.size() - 1;
+            }
+
+            static bool earlier(const ScheduledEntry& a, const ScheduledEntry& b) {
+                return (a.time != b.time) ? (a.time < b.time) : ((int32_t)(a.seq - b.seq) < 0);
+            }
+
+            void siftUp(size_t i) {
+                while (i > 0) {
+                    const size_t parent = (i - 1) / 2;
+                    if (!earlier(heap[i], heap[parent])) break;
+                    swap(i, parent);
+                    i = parent;
+                }
+            }
+
+            void siftDown(size_t i) {
+                const size_t n = heap.size();
+                while (true) {
+                    const size_t l = 2 * i + 1;
+                    const size_t r = l + 1;
+                    size_t m = i;
+                    if ((l < n) && earlier(heap[l], heap[m])) m = l;
+                    if ((r < n) && earlier(heap[r], heap[m])) m = r;
+                    if (m == i) break;
+                    swap(i, m);
+                    i = m;
+                }
+            }
+
+            void swap(const size_t a, const size_t b) {
+                const ScheduledEntry tmp = heap[a];
+                heap[a] = heap[b];
+                heap[b] = tmp;
+            }
+
+            // NTP time tag duration (32.32 fixed point seconds) to microseconds
+            static uint32_t toMicros(const uint64_t d) {
+                const uint64_t sec = d >> 32;
+                if (sec >= 4294) return UINT32_MAX;
+                return (uint32_t)(sec * 1000000ULL + (((d & 0xFFFFFFFFULL) * 1000000ULL) >> 32));
+            }
+#endif  // ARDUINOOSC_DISABLE_SCHEDULER
+        };
+
+    }  // namespace server
+}  // namespace osc
+}  // namespace arduino
+
+using OscScheduler = arduino::osc::server::Scheduler;
+using OscLatePolicy = arduino::osc::server::LatePolicy;
+
+#endif  // ARDUINOOSC_DISABLE_BUNDLE
+
+#endif  // ARDUINOOSC_OSCSCHEDULER_H
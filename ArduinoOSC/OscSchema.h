@@ -0,0 +1,311 @@
+#pragma once
+
+#ifndef ARDUINOOSC_OSCSCHEMA_H
+#define ARDUINOOSC_OSCSCHEMA_H
+
+#include <Arduino.h>
+#include <ArxTypeTraits.h>
+#include <DebugLog.h>
+#include "OscTypes.h"
+#include "OscUtil.h"
+#include "OscMessage.h"
+
+namespace arduino {
+namespace osc {
+    namespace message {
+
+        namespace schema {
+
+            // argument traits: type tag, (minimum) byte size and how to read/write it
+            template <typename T, typename = void>
+            struct Arg;
+
+            template <typename T>
+            struct FixedArg {
+                static constexpr bool fixed = true;
+                static size_t size(const T&) { return sizeof(T); }
+                static void store(char* p, const T& v) { pod2bytes<T>(v, p); }
+                static bool load(const char* p, const char*, T& v) {
+                    v = bytes2pod<T>(p);
+                    return true;
+                }
+            };
+
+            template <typename T>
+            struct Arg<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value && (sizeof(T) <= 4)>::type> {
+                static constexpr char tag = TYPE_TAG_INT32;
+                static constexpr size_t min_size = 4;
+                static constexpr bool fixed = true;
+                static size_t size(const T&) { return 4; }
+                static void store(char* p, const T& v) { pod2bytes<int32_t>((int32_t)v, p); }
+                static bool load(const char* p, const char*, T& v) {
+                    v = (T)bytes2pod<int32_t>(p);
+                    return true;
+                }
+            };
+
+            template <typename T>
+            struct Arg<T, typename std::enable_if<std::is_integral<T>::value && (sizeof(T) == 8)>::type> {
+                static constexpr char tag = TYPE_TAG_INT64;
+                static constexpr size_t min_size = 8;
+                static constexpr bool fixed = true;
+                static size_t size(const T&) { return 8; }
+                static void store(char* p, const T& v) { pod2bytes<int64_t>((int64_t)v, p); }
+                static bool load(const char* p, const char*, T& v) {
+                    v = (T)bytes2pod<int64_t>(p);
+                    return true;
+                }
+            };
+
+            template <>
+            struct Arg<float> : FixedArg<float> {
+                static constexpr char tag = TYPE_TAG_FLOAT;
+                static constexpr size_t min_size = 4;
+            };
+
+            template <>
+            struct Arg<double> : FixedArg<double> {
+                static constexpr char tag = TYPE_TAG_DOUBLE;
+                static constexpr size_t min_size = 8;
+            };
+
+            // variable size arguments are allowed only as the last one
+            template <>
+            struct Arg<BlobView> {
+                static constexpr char tag = TYPE_TAG_BLOB;
+                static constexpr size_t min_size = 4;
+                static constexpr bool fixed = false;
+                static size_t size(const BlobView& v) { return 4 + ceil4(v.size()); }
+                static void store(char* p, const BlobView& v) {
+                    pod2bytes<uint32_t>((uint32_t)v.size(), p);
+                    if (v.size()) memcpy(p + 4, v.data(), v.size());
+                    memset(p + 4 + v.size(), 0, ceil4(v.size()) - v.size());
+                }
+                static bool load(const char* p, const char* end, BlobView& v) {
+                    if (end - p < 4) return false;
+                    const uint32_t n = bytes2pod<uint32_t>(p);
+                    if ((size_t)(end - p - 4) < n) return false;
+                    v = BlobView(p + 4, n);
+                    return true;
+                }
+                template <typename S>
+                static void write(S& s, const BlobView& v) {
+                    static const uint8_t zeros[4] = {0, 0, 0, 0};
+                    char sz[4];
+                    pod2bytes<uint32_t>((uint32_t)v.size(), sz);
+                    s.write((const uint8_t*)sz, 4);
+                    if (v.size()) s.write(v.data(), v.size());
+                    if (ceil4(v.size()) - v.size()) s.write(zeros, ceil4(v.size()) - v.size());
+                }
+            };
+
+            template <>
+            struct Arg<StringView> {
+                static constexpr char tag = TYPE_TAG_STRING;
+                static constexpr size_t min_size = 4;
+                static constexpr bool fixed = false;
+                static size_t size(const StringView& v) { return ceil4(v.size() + 1); }
+                static void store(char* p, const StringView& v) {
+                    memcpy(p, v.data(), v.size());
+                    memset(p + v.size(), 0, ceil4(v.size() + 1) - v.size());
+                }
+                static bool load(const char* p, const char* end, StringView& v) {
+                    const char* q = (const char*)memchr(p, 0, end - p);
+                    if (!q) return false;
+                    v = StringView(p, q - p);
+                    return true;
+                }
+                template <typename S>
+                static void write(S& s, const StringView& v) {
+                    static const uint8_t zeros[4] = {0, 0, 0, 0};
+                    s.write((const uint8_t*)v.data(), v.size());
+                    s.write(zeros, ceil4(v.size() + 1) - v.size());
+                }
+            };
+
+            // byte offset of the I-th argument, which is fixed for all arguments
+            template <size_t I, typename... Ts>
+            struct Offset;
+            template <typename T, typename... Ts>
+            struct Offset<0, T, Ts...> {
+                static constexpr size_t value = 0;
+            };
+            template <size_t I, typename T, typename... Ts>
+            struct Offset<I, T, Ts...> {
+                static constexpr size_t value = Arg<T>::min_size + Offset<I - 1, Ts...>::value;
+            };
+
+            template <typename... Ts>
+            struct Layout;
+            template <>
+            struct Layout<> {
+                static constexpr size_t min_size = 0;
+                static constexpr bool fixed = true;
+                static constexpr bool valid = true;
+            };
+            template <typename T, typename... Ts>
+            struct Layout<T, Ts...> {
+                static constexpr size_t min_size = Arg<T>::min_size + Layout<Ts...>::min_size;
+                static constexpr bool fixed = Arg<T>::fixed && Layout<Ts...>::fixed;
+                static constexpr bool valid = (Arg<T>::fixed || (sizeof...(Ts) == 0)) && Layout<Ts...>::valid;
+            };
+
+            template <typename... Ts>
+            struct Last;
+            template <typename T>
+            struct Last<T> {
+                using type = T;
+            };
+            template <typename T, typename... Ts>
+            struct Last<T, Ts...> {
+                using type = typename Last<Ts...>::type;
+            };
+
+        }  // namespace schema
+
+        // OSC message whose argument types are fixed at compile time
+        // type tags and argument offsets are compile-time constants,
+        // only the address is given at runtime and encoded once in the constructor
+        template <typename... Ts>
+        class Schema {
+            static_assert(schema::Layout<Ts...>::valid, "only the last argument of a schema can be a string or a blob");
+
+            using Layout = schema::Layout<Ts...>;
+            using PrefixString = InlineString<ARDUINOOSC_MSG_ADDRESS_INLINE_SIZE + ARDUINOOSC_MSG_TYPE_TAG_INLINE_SIZE + 8>;
+
+            PrefixString prefix;  // padded address + padded type tags
+            size_t address_len {0};
+
+        public:
+            static constexpr size_t num_args = sizeof...(Ts);
+            static constexpr char type_tags[sizeof...(Ts) + 2] = {',', schema::Arg<Ts>::tag..., '\0'};
+            static constexpr size_t type_tags_size = (sizeof...(Ts) + 2 + 3) & ~size_t(3);
+            static constexpr size_t args_size = Layout::min_size;  // exact size if all arguments are fixed size
+            static constexpr bool fixed = Layout::fixed;
+
+            explicit Schema(const char* addr) {
+                address_len = strlen(addr);
+                prefix.append(addr, address_len);
+                prefix.append('\0', ceil4(address_len + 1) - address_len);
+                prefix.append(type_tags, sizeof(type_tags));
+                prefix.append('\0', type_tags_size - sizeof(type_tags));
+            }
+            explicit Schema(const String& addr)
+            : Schema(addr.c_str()) {}
+
+            const char* address() const { return prefix.c_str(); }
+            size_t addressLength() const { return address_len; }
+
+            // exact encoded size of the message with given values
+            template <typename... Vs>
+            size_t encodedSize(const Vs&... vs) const {
+                return prefix.length() + argsSize(std::index_sequence_for<Ts...>(), vs...);
+            }
+
+            // write the whole message to buf which has at least encodedSize(vs...) bytes
+            template <typename... Vs>
+            size_t encode(char* buf, const Vs&... vs) const {
+                static_assert(sizeof...(Vs) == sizeof...(Ts), "number of values must match the schema");
+                memcpy(buf, prefix.c_str(), prefix.length());
+                storeArgs(std::index_sequence_for<Ts...>(), buf + prefix.length(), std::forward_as_tuple(vs...));
+                return encodedSize(vs...);
+            }
+
+            // write the whole message to a stream (e.g. between beginPacket() and endPacket())
+            template <typename S, typename... Vs>
+            void write(S& s, const Vs&... vs) const {
+                static_assert(sizeof...(Vs) == sizeof...(Ts), "number of values must match the schema");
+                s.write((const uint8_t*)prefix.c_str(), prefix.length());
+                writeArgs(s, std::integral_constant<bool, fixed>(), vs...);
+            }
+
+            // one memcmp against the expected type tags
+            static bool match(const Message& m) {
+                return (m.size() == num_args) && (memcmp(m.typeTagsCStr(), type_tags + 1, num_args) == 0);
+            }
+
+            static bool decode(const Message& m, Ts&... ts) {
+                std::tuple<Ts&...> t(ts...);
+                return decode(m, t);
+            }
+
+            template <typename Tuple>
+            static bool decode(const Message& m, Tuple& t) {
+                if (!match(m)) {
+                    LOG_ERROR(F("type tags mismatch: msg"), m.typeTagsCStr(), F("/ schema"), type_tags + 1);
+                    return false;
+                }
+                return decode(m.argsBegin(), m.argsEnd(), t);
+            }
+
+            // decode from the raw argument bytes which follow the type tags
+            template <typename Tuple>
+            static bool decode(const char* beg, const char* end, Tuple& t) {
+                if ((size_t)(end - beg) < args_size) {
+                    LOG_ERROR(F("argument size is too small"));
+                    return false;
+                }
+                return loadArgs(std::index_sequence_for<Ts...>(), beg, end, t);
+            }
+
+        private:
+            template <size_t I>
+            using ArgType = typename std::tuple_element<I, std::tuple<Ts...>>::type;
+
+            template <size_t... Is, typename... Vs>
+            static size_t argsSize(std::index_sequence<Is...>&&, const Vs&... vs) {
+                size_t sz = 0;
+                size_t dummy[] = {0, (sz += schema::Arg<Ts>::size(static_cast<Ts>(vs)))...};
+                (void)dummy;
+                return sz;
+            }
+
+            // store the arguments of indices Is at their fixed offsets
+            template <size_t... Is, typename Values>
+            static void storeArgs(std::index_sequence<Is...>&&, char* p, const Values& vs) {
+                int dummy[] = {0, (schema::Arg<ArgType<Is>>::store(p + schema::Offset<Is, Ts...>::value, static_cast<ArgType<Is>>(std::get<Is>(vs))), 0)...};
+                (void)p;
+                (void)vs;
+                (void)dummy;
+            }
+
+            template <size_t... Is, typename Tuple>
+            static bool loadArgs(std::index_sequence<Is...>&&, const char* beg, const char* end, Tuple& t) {
+                bool ok = true;
+                bool dummy[] = {true, (ok = schema::Arg<Ts>::load(beg + schema::Offset<Is, Ts...>::value, end, std::get<Is>(t)) && ok)...};
+                (void)dummy;
+                return ok;
+            }
+
+            // all fixed: encode to a stack buffer and write it at once
+            template <typename S, typename... Vs>
+            void writeArgs(S& s, std::true_type, const Vs&... vs) const {
+                char buf[args_size ? args_size : 1];
+                storeArgs(std::index_sequence_for<Ts...>(), buf, std::forward_as_tuple(vs...));
+                if (args_size) s.write((const uint8_t*)buf, args_size);
+            }
+
+            // the last argument is a string or a blob: write the fixed part and then the last one
+            template <typename S, typename... Vs>
+            void writeArgs(S& s, std::false_type, const Vs&... vs) const {
+                using LastT = typename schema::Last<Ts...>::type;
+                constexpr size_t fixed_size = args_size - schema::Arg<LastT>::min_size;
+                char buf[fixed_size ? fixed_size : 1];
+                const auto values = std::forward_as_tuple(vs...);
+                storeArgs(std::make_index_sequence<sizeof...(Ts) - 1>(), buf, values);
+                if (fixed_size) s.write((const uint8_t*)buf, fixed_size);
+                schema::Arg<LastT>::write(s, static_cast<LastT>(std::get<sizeof...(Ts) - 1>(values)));
+            }
+        };
+
+        template <typename... Ts>
+        constexpr char Schema<Ts...>::type_tags[sizeof...(Ts) + 2];
+
+    }  // namespace message
+}  // namespace osc
+}  // namespace arduino
+
+template <typename... Ts>
+using OscSchema = arduino::osc::message::Schema<Ts...>;
+
+#endif  // ARDUINOOSC_OSCSCHEMA_H
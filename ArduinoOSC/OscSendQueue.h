@@ -0,0 +1,340 @@
+#pragma once
+
+#ifndef ARDUINOOSC_OSCSENDQUEUE_H
+#define ARDUINOOSC_OSCSENDQUEUE_H
+
+#include <Arduino.h>
+#include <DebugLog.h>
+#include "OscTypes.h"
+#include "OscUdpMap.h"
+
+#ifdef ARDUINOOSC_HAVE_THREAD
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifndef ARDUINOOSC_SEND_QUEUE_SIZE
+#define ARDUINOOSC_SEND_QUEUE_SIZE 64  // rounded up to a power of two
+#endif
+#ifndef ARDUINOOSC_SEND_FLUSH_BATCH
+#define ARDUINOOSC_SEND_FLUSH_BATCH 16  // packets written under one lock of the udp
+#endif
+
+namespace arduino {
+namespace osc {
+    namespace client {
+
+        // what to do when a packet is sent while the send queue is full
+        enum class SendOverflow : uint8_t {
+            BLOCK,        // wait for the flusher (or flush in the sending thread if there is no flusher thread)
+            DROP_OLDEST,  // discard the oldest queued packet
+            DROP_NEWEST,  // discard the packet being sent
+        };
+
+        // an encoded packet and its destination in a slot of SendQueue
+        // the buffers are kept when the slot is reused, so that queueing doesn't allocate
+        struct SendPacket {
+            server::PacketBuffer data;
+            size_t len {0};
+            String host;
+            IPAddress ip;
+            bool by_ip {false};
+            uint16_t port {0};
+
+            void clear() { len = 0; }
+            size_t size() const { return len; }
+
+            // n bytes appended to the packet
+            uint8_t* reserve(const size_t n) {
+                if (data.size() < len + n) data.resize(len + n);
+                uint8_t* p = &data.front() + len;
+                len += n;
+                return p;
+            }
+            // the packet can be written like a stream (e.g. by Schema::write() or StreamEncoder)
+            size_t write(const uint8_t* b, const size_t n) {
+                if (n) memcpy(reserve(n), b, n);
+                return n;
+            }
+            size_t write(const uint8_t b) {
+                *reserve(1) = b;
+                return 1;
+            }
+
+            void destination(const String& h, const uint16_t p) { destination(h.c_str(), p); }
+            void destination(const char* h, const uint16_t p) {
+                host = h;
+                by_ip = false;
+                port = p;
+            }
+            void destination(const IPAddress& i, const uint16_t p) {
+                ip = i;
+                by_ip = true;
+                port = p;
+            }
+        };
+
+        struct SendQueueStats {
+            uint32_t queued {0};   // packets queued by send()
+            uint32_t sent {0};     // packets written into the udp
+            uint32_t dropped {0};  // packets discarded by SendOverflow::DROP_OLDEST or DROP_NEWEST
+            uint32_t stalls {0};   // sends which waited because of SendOverflow::BLOCK
+            uint32_t errors {0};   // packets which endPacket() failed to send
+            size_t depth {0};      // packets in the queue now
+            size_t max_depth {0};  // high-water mark
+        };
+
+        // bounded multi-producer queue of encoded packets, which are sent in batches by flush()
+        // flush() is called by its own thread, or by the application (e.g. in loop() on boards)
+        // each slot has a sequence number which tells if it is free or filled for the current lap,
+        // so the producers encode into the slots in parallel without locks
+        template <typename S>
+        class SendQueue {
+            struct Slot {
+                std::atomic<size_t> seq {0};
+                SendPacket packet;
+            };
+
+            std::unique_ptr<Slot[]> slots;
+            size_t mask {0};
+            std::atomic<size_t> head {0};  // next slot to be filled by the producers
+            char pad_head[64 - sizeof(std::atomic<size_t>)];
+            std::atomic<size_t> tail {0};  // next slot to be sent
+            char pad_tail[64 - sizeof(std::atomic<size_t>)];
+
+            UdpRef<S> stream;
+            SendOverflow policy {SendOverflow::BLOCK};
+            std::thread th;
+            std::atomic<bool> running {false};
+            std::atomic<bool> sleeping {false};
+            std::mutex wake_mtx;
+            std::condition_variable wake;
+
+            std::atomic<uint32_t> num_queued {0};
+            std::atomic<uint32_t> num_sent {0};
+            std::atomic<uint32_t> num_dropped {0};
+            std::atomic<uint32_t> num_stalls {0};
+            std::atomic<uint32_t> num_errors {0};
+            std::atomic<size_t> max_depth {0};
+
+        public:
+            ~SendQueue() { stop(); }
+
+            // with_thread = false leaves flush() to the application, the stats are reset
+            bool start(const UdpRef<S>& s, const size_t queue_size, const SendOverflow p, const bool with_thread = true) {
+                if (slots) return false;
+                size_t sz = 1;
+                while (sz < queue_size) sz *= 2;
+                slots.reset(new Slot[sz]);
+                for (size_t i = 0; i < sz; ++i) slots[i].seq.store(i, std::memory_order_relaxed);
+                mask = sz - 1;
+                head.store(0, std::memory_order_relaxed);
+                tail.store(0, std::memory_order_relaxed);
+                stream = s;
+                policy = p;
+                num_queued.store(0);
+                num_sent.store(0);
+                num_dropped.store(0);
+                num_stalls.store(0);
+                num_errors.store(0);
+                max_depth.store(0);
+                if (with_thread) {
+                    running.store(true);
+                    th = std::thread([this] { run(); });
+                }
+                return true;
+            }
+
+            // the queued packets are sent before it returns
+            void stop() {
+                if (running.exchange(false)) {
+                    {
+                        std::lock_guard<std::mutex> lock(wake_mtx);
+                    }
+                    wake.notify_one();
+                    if (th.joinable()) th.join();
+                }
+                if (!slots) return;
+                flush();
+                slots.reset();
+                stream = UdpRef<S>();
+            }
+
+            bool isRunning() const { return (bool)slots; }
+            bool hasThread() const { return running.load(); }
+            size_t capacity() const { return mask + 1; }
+            size_t size() const {
+                const size_t t = tail.load(std::memory_order_acquire);
+                const size_t h = head.load(std::memory_order_acquire);
+                return (h > t) ? (h - t) : 0;
+            }
+
+            SendQueueStats stats() const {
+                SendQueueStats s;
+                s.queued = num_queued.load(std::memory_order_relaxed);
+                s.sent = num_sent.load(std::memory_order_relaxed);
+                s.dropped = num_dropped.load(std::memory_order_relaxed);
+                s.stalls = num_stalls.load(std::memory_order_relaxed);
+                s.errors = num_errors.load(std::memory_order_relaxed);
+                s.depth = size();
+                s.max_depth = max_depth.load(std::memory_order_relaxed);
+                return s;
+            }
+
+            // queue a packet to ip:port which is written by f(SendPacket&)
+            // returns false if it was dropped by SendOverflow::DROP_NEWEST
+            template <typename IP, typename F>
+            bool push(const IP& ip, const uint16_t port, F&& f) {
+                size_t pos;
+                Slot* slot = claim(pos);
+                bool stalled = false;
+                while (!slot) {
+                    if (policy == SendOverflow::DROP_NEWEST) {
+                        num_dropped.fetch_add(1, std::memory_order_relaxed);
+                        return false;
+                    } else if (policy == SendOverflow::DROP_OLDEST) {
+                        // fails while the oldest slot is being written or sent by another thread
+                        if (consume([](SendPacket&) {}))
+                            num_dropped.fetch_add(1, std::memory_order_relaxed);
+                        else
+                            std::this_thread::yield();
+                    } else {
+                        if (!stalled) num_stalls.fetch_add(1, std::memory_order_relaxed);
+                        stalled = true;
+                        if (running.load(std::memory_order_relaxed)) {
+                            notify();
+                            std::this_thread::yield();
+                        } else {
+                            flush();
+                        }
+                    }
+                    slot = claim(pos);
+                }
+                SendPacket& p = slot->packet;
+                p.clear();
+                p.destination(ip, port);
+                f(p);
+                slot->seq.store(pos + 1, std::memory_order_seq_cst);
+
+                num_queued.fetch_add(1, std::memory_order_relaxed);
+                const size_t depth = size();
+                size_t prev = max_depth.load(std::memory_order_relaxed);
+                while ((depth > prev) && !max_depth.compare_exchange_weak(prev, depth, std::memory_order_relaxed)) {
+                }
+                // the flusher is woken only when it waits, so that a burst doesn't lock wake_mtx for every packet
+                if (sleeping.load(std::memory_order_seq_cst)) notify();
+                return true;
+            }
+
+            // send up to max_packets queued packets (0 means all), returns the number of sent packets
+            // the udp is locked once per ARDUINOOSC_SEND_FLUSH_BATCH packets
+            size_t flush(const size_t max_packets = 0) {
+                if (!slots) return 0;
+                size_t n = 0;
+                while (!max_packets || (n < max_packets)) {
+                    size_t batch = 0;
+                    {
+                        std::lock_guard<std::mutex> lock(UdpMapManager<S>::getInstance().packetMutex(stream.get()));
+                        while ((batch < ARDUINOOSC_SEND_FLUSH_BATCH) && (!max_packets || (n + batch < max_packets))) {
+                            if (!consume([this](SendPacket& p) { write(p); })) break;
+                            ++batch;
+                        }
+                    }
+                    n += batch;
+                    if (batch < ARDUINOOSC_SEND_FLUSH_BATCH) break;
+                }
+                return n;
+            }
+
+        private:
+            // a free slot for the producer, or nullptr if the queue is full
+            Slot* claim(size_t& pos) {
+                pos = head.load(std::memory_order_relaxed);
+                while (true) {
+                    Slot* slot = &slots[pos & mask];
+                    const size_t seq = slot->seq.load(std::memory_order_acquire);
+                    const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+                    if (diff == 0) {
+                        if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) return slot;
+                    } else if (diff < 0) {
+                        return nullptr;
+                    } else {
+                        pos = head.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            // pass the oldest packet to f(SendPacket&) and free the slot, false if there is none
+            template <typename F>
+            bool consume(F&& f) {
+                size_t pos = tail.load(std::memory_order_relaxed);
+                while (true) {
+                    Slot* slot = &slots[pos & mask];
+                    const size_t seq = slot->seq.load(std::memory_order_seq_cst);
+                    const intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+                    if (diff == 0) {
+                        if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                            f(slot->packet);
+                            slot->seq.store(pos + mask + 1, std::memory_order_release);
+                            return true;
+                        }
+                    } else if (diff < 0) {
+                        return false;
+                    } else {
+                        pos = tail.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            // the oldest packet is filled and can be sent
+            bool ready() const {
+                const size_t t = tail.load(std::memory_order_seq_cst);
+                return slots[t & mask].seq.load(std::memory_order_seq_cst) == t + 1;
+            }
+
+            void write(SendPacket& p) {
+                if (p.by_ip)
+                    stream->beginPacket(p.ip, p.port);
+                else
+                    stream->beginPacket(p.host.c_str(), p.port);
+                if (p.size()) stream->write(&p.data.front(), p.size());
+                if (stream->endPacket())
+                    num_sent.fetch_add(1, std::memory_order_relaxed);
+                else
+                    num_errors.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            void notify() {
+                {
+                    std::lock_guard<std::mutex> lock(wake_mtx);
+                }
+                wake.notify_one();
+            }
+
+            void run() {
+                while (running.load(std::memory_order_relaxed)) {
+                    if (flush()) continue;
+                    std::unique_lock<std::mutex> lock(wake_mtx);
+                    // push() publishes the slot before it reads sleeping, and the predicate reads the slot after
+                    // sleeping is set (both seq_cst), so either push() notifies or the wait doesn't block
+                    sleeping.store(true, std::memory_order_seq_cst);
+                    wake.wait(lock, [&] {
+                        return ready() || !running.load(std::memory_order_relaxed);
+                    });
+                    sleeping.store(false, std::memory_order_relaxed);
+                }
+            }
+        };
+
+    }  // namespace client
+}  // namespace osc
+}  // namespace arduino
+
+using OscSendOverflow = arduino::osc::client::SendOverflow;
+using OscSendQueueStats = arduino::osc::client::SendQueueStats;
+
+#endif  // ARDUINOOSC_HAVE_THREAD
+
+#endif  // ARDUINOOSC_OSCSENDQUEUE_H
@@ -13,6 +13,13 @@
 namespace arduino {
 namespace osc {
 
+#ifndef ARDUINOOSC_MSG_ADDRESS_INLINE_SIZE
+#define ARDUINOOSC_MSG_ADDRESS_INLINE_SIZE 64
+#endif
+#ifndef ARDUINOOSC_MSG_TYPE_TAG_INLINE_SIZE
+#define ARDUINOOSC_MSG_TYPE_TAG_INLINE_SIZE 16
+#endif
+
     static constexpr uint16_t PORT_DISCARD {9};
     template <typename S>
     using UdpRef = std::shared_ptr<S>;
@@ -38,18 +45,42 @@ namespace osc {
         using ElementRef = element::Ref;
         using ElementTupleRef = element::TupleRef;
         using DestinationMap = std::map<Destination, ElementRef>;
+        struct PublishEntry;
+        using PublishHeap = std::vector<PublishEntry>;
     }  // namespace client
 
     namespace server {
         namespace element {
             class Base;
-            using Ref = std::shared_ptr<Base>;
-            using TupleRef = std::vector<Ref>;
-            using dummy_vector_t = std::vector<size_t>;
+            class Ref;
         }  // namespace element
         using ElementRef = element::Ref;
-        using ElementTupleRef = element::TupleRef;
         using CallbackMap = std::map<String, ElementRef>;
+        struct DispatchEntry;
+        using DispatchEntries = std::vector<DispatchEntry>;
+#ifndef ARDUINOOSC_MAX_DISPATCH_CACHE_SIZE
+#define ARDUINOOSC_MAX_DISPATCH_CACHE_SIZE 1024
+#endif
+        struct DispatchCacheSlot;
+        using DispatchElements = std::vector<element::Base*>;
+        using DispatchCacheSlots = std::vector<DispatchCacheSlot>;
+        struct MethodNode;
+        using MethodNodes = std::vector<MethodNode>;
+        struct MethodWalkState;
+        using MethodWalk = std::vector<MethodWalkState>;
+#ifndef ARDUINOOSC_MAX_RECV_PACKET_SIZE
+#define ARDUINOOSC_MAX_RECV_PACKET_SIZE 65507  // max UDP payload, the buffer grows up to the largest packet
+#endif
+        using PacketBuffer = std::vector<uint8_t>;
+#ifndef ARDUINOOSC_DISABLE_BUNDLE
+#ifndef ARDUINOOSC_MAX_SCHEDULED_MSG_SIZE
+#define ARDUINOOSC_MAX_SCHEDULED_MSG_SIZE 64
+#endif
+        struct ScheduledEntry;
+        using ScheduledMessages = std::vector<message::Message>;
+        using ScheduledHeap = std::vector<ScheduledEntry>;
+        using ScheduledSlots = std::vector<size_t>;
+#endif
         template <typename S>
         class Server;
         template <typename S>
@@ -86,6 +117,12 @@ namespace osc {
 #endif
 #ifndef ARDUINOOSC_MAX_MSG_BUNDLE_SIZE
 #define ARDUINOOSC_MAX_MSG_BUNDLE_SIZE 128
+#endif
+#ifndef ARDUINOOSC_MSG_ADDRESS_INLINE_SIZE
+#define ARDUINOOSC_MSG_ADDRESS_INLINE_SIZE 32
+#endif
+#ifndef ARDUINOOSC_MSG_TYPE_TAG_INLINE_SIZE
+#define ARDUINOOSC_MSG_TYPE_TAG_INLINE_SIZE (ARDUINOOSC_MAX_MSG_ARGUMENT_SIZE + 1)
 #endif
 
     static constexpr uint16_t PORT_DISCARD {9};
@@ -115,18 +152,61 @@ namespace osc {
         using ElementRef = element::Ref;
         using ElementTupleRef = element::TupleRef;
         using DestinationMap = arx::stdx::map<Destination, ElementRef, ARDUINOOSC_MAX_PUBLISH_DESTINATION>;
+        struct PublishEntry;
+        using PublishHeap = arx::stdx::vector<PublishEntry, ARDUINOOSC_MAX_PUBLISH_DESTINATION>;
     }  // namespace client
 
     namespace server {
         namespace element {
             class Base;
-            using Ref = std::shared_ptr<Base>;
-            using TupleRef = arx::stdx::vector<Ref, ARDUINOOSC_MAX_MSG_ARGUMENT_SIZE>;
-            using dummy_vector_t = arx::stdx::vector<size_t, ARDUINOOSC_MAX_MSG_ARGUMENT_SIZE>;
+            class Ref;
         }  // namespace element
         using ElementRef = element::Ref;
-        using ElementTupleRef = element::TupleRef;
         using CallbackMap = arx::stdx::map<String, ElementRef, ARDUINOOSC_MAX_SUBSCRIBE_ADDRESS_PER_PORT>;
+        struct DispatchEntry;
+        using DispatchEntries = arx::stdx::vector<DispatchEntry, ARDUINOOSC_MAX_SUBSCRIBE_ADDRESS_PER_PORT>;
+#ifndef ARDUINOOSC_MAX_DISPATCH_CACHE_SIZE
+#define ARDUINOOSC_MAX_DISPATCH_CACHE_SIZE 0  // each slot holds an address, define it to use the cache
+#endif
+#if ARDUINOOSC_MAX_DISPATCH_CACHE_SIZE > 0
+        struct DispatchCacheSlot;
+        using DispatchElements = arx::stdx::vector<element::Base*, ARDUINOOSC_MAX_SUBSCRIBE_ADDRESS_PER_PORT>;
+        using DispatchCacheSlots = arx::stdx::vector<DispatchCacheSlot, ARDUINOOSC_MAX_DISPATCH_CACHE_SIZE>;
+#elif !defined(ARDUINOOSC_DISABLE_DISPATCH_CACHE)
+#define ARDUINOOSC_DISABLE_DISPATCH_CACHE
+#endif
+#ifndef ARDUINOOSC_MAX_METHOD_TREE_NODES
+#define ARDUINOOSC_MAX_METHOD_TREE_NODES 0  // define it (e.g. ARDUINOOSC_MAX_SUBSCRIBE_ADDRESS_PER_PORT * 4) for message patterns
+#endif
+#if ARDUINOOSC_MAX_METHOD_TREE_NODES > 0
+        struct MethodNode;
+        using MethodNodes = arx::stdx::vector<MethodNode, ARDUINOOSC_MAX_METHOD_TREE_NODES>;
+        struct MethodWalkState;
+        using MethodWalk = arx::stdx::vector<MethodWalkState, ARDUINOOSC_MAX_METHOD_TREE_NODES>;
+#elif !defined(ARDUINOOSC_DISABLE_METHOD_TREE)
+#define ARDUINOOSC_DISABLE_METHOD_TREE
+#endif
+#ifndef ARDUINOOSC_MAX_RECV_PACKET_SIZE
+#ifdef ARDUINOOSC_DISABLE_BUNDLE
+#define ARDUINOOSC_MAX_RECV_PACKET_SIZE ARDUINOOSC_MAX_MSG_BYTE_SIZE  // a packet is one message
+#else
+#define ARDUINOOSC_MAX_RECV_PACKET_SIZE (ARDUINOOSC_MAX_MSG_BYTE_SIZE * 2)  // a bundle can hold more than one
+#endif
+#endif
+        using PacketBuffer = arx::stdx::vector<uint8_t, ARDUINOOSC_MAX_RECV_PACKET_SIZE>;
+#ifndef ARDUINOOSC_DISABLE_BUNDLE
+#ifndef ARDUINOOSC_MAX_SCHEDULED_MSG_SIZE
+#define ARDUINOOSC_MAX_SCHEDULED_MSG_SIZE 0  // each slot is a whole Message, define it to use the scheduler
+#endif
+#if ARDUINOOSC_MAX_SCHEDULED_MSG_SIZE > 0
+        struct ScheduledEntry;
+        using ScheduledMessages = arx::stdx::vector<message::Message, ARDUINOOSC_MAX_SCHEDULED_MSG_SIZE>;
+        using ScheduledHeap = arx::stdx::vector<ScheduledEntry, ARDUINOOSC_MAX_SCHEDULED_MSG_SIZE>;
+        using ScheduledSlots = arx::stdx::vector<size_t, ARDUINOOSC_MAX_SCHEDULED_MSG_SIZE>;
+#elif !defined(ARDUINOOSC_DISABLE_SCHEDULER)
+#define ARDUINOOSC_DISABLE_SCHEDULER
+#endif
+#endif
         template <typename S>
         class Server;
         template <typename S>
@@ -140,6 +220,29 @@ namespace osc {
 
 #endif
 
+#if defined(__has_include) && (__cplusplus >= 201703L)
+#if __has_include(<string_view>)
+#include <string_view>
+#define ARDUINOOSC_HAVE_STRING_VIEW
+#endif
+#endif
+#if defined(__has_include) && (__cplusplus >= 202002L)
+#if __has_include(<span>)
+#include <span>
+#define ARDUINOOSC_HAVE_SPAN
+#endif
+#endif
+#if !defined(ARDUINOOSC_DISABLE_THREAD) && (ARX_HAVE_LIBSTDCPLUSPLUS >= 201103L) && defined(__has_include)
+#if __has_include(<thread>) && __has_include(<atomic>)
+#include <atomic>
+#include <thread>
+// some toolchains (e.g. ESP8266) have the headers without thread support
+#if defined(_GLIBCXX_HAS_GTHREADS) || defined(_LIBCPP_VERSION)
+#define ARDUINOOSC_HAVE_THREAD
+#endif
+#endif
+#endif
+
 #include "OscUtil.h"
 
 namespace arduino {
@@ -169,12 +272,147 @@ namespace osc {
         static TimeTag immediate() { return TimeTag(1); }
     };
 
+    // non-owning reference to a string argument in the packet (always null-terminated)
+    class StringView {
+        const char* ptr {""};
+        size_t len {0};
+
+    public:
+        StringView() {}
+        StringView(const char* s)
+        : ptr(s ? s : ""), len(s ? strlen(s) : 0) {}
+        StringView(const char* s, const size_t n)
+        : ptr(s ? s : ""), len(s ? n : 0) {}
+        StringView(const String& s)
+        : ptr(s.c_str()), len(s.length()) {}
+
+        const char* data() const { return ptr; }
+        const char* c_str() const { return ptr; }
+        size_t size() const { return len; }
+        size_t length() const { return len; }
+        bool empty() const { return len == 0; }
+        const char* begin() const { return ptr; }
+        const char* end() const { return ptr + len; }
+        char operator[](const size_t i) const { return ptr[i]; }
+
+        bool operator==(const StringView& rhs) const { return (len == rhs.len) && (memcmp(ptr, rhs.ptr, len) == 0); }
+        bool operator!=(const StringView& rhs) const { return !(*this == rhs); }
+        bool operator==(const char* rhs) const { return *this == StringView(rhs); }
+        bool operator!=(const char* rhs) const { return !(*this == rhs); }
+
+        String toString() const { return String(ptr); }
+#ifdef ARDUINOOSC_HAVE_STRING_VIEW
+        operator std::string_view() const { return std::string_view(ptr, len); }
+#endif
+    };
+
+    // non-owning reference to a blob argument in the packet
+    class BlobView {
+        const uint8_t* ptr {nullptr};
+        size_t len {0};
+
+    public:
+        BlobView() {}
+        BlobView(const void* p, const size_t n)
+        : ptr((const uint8_t*)p), len(p ? n : 0) {}
+        BlobView(const Blob& b)
+        : ptr((const uint8_t*)b.data()), len(b.size()) {}
+
+        const uint8_t* data() const { return ptr; }
+        size_t size() const { return len; }
+        bool empty() const { return len == 0; }
+        const uint8_t* begin() const { return ptr; }
+        const uint8_t* end() const { return ptr + len; }
+        uint8_t operator[](const size_t i) const { return ptr[i]; }
+
+        Blob toBlob() const {
+            Blob b;
+            if (len) b.assign((const char*)ptr, (const char*)ptr + len);
+            return b;
+        }
+#ifdef ARDUINOOSC_HAVE_SPAN
+        operator std::span<const uint8_t>() const { return std::span<const uint8_t>(ptr, len); }
+#endif
+    };
+
+    // null-terminated string stored in an inline buffer
+    // on libstdc++ targets it moves to the heap only if the inline buffer is exceeded
+    template <size_t N>
+    class InlineString {
+        char buf[N];
+        size_t len {0};
+#if ARX_HAVE_LIBSTDCPLUSPLUS >= 201103L  // Have libstdc++11
+        std::vector<char> ext;
+#endif
+
+    public:
+        InlineString() { buf[0] = 0; }
+        InlineString(const char* s) { assign(s, strlen(s)); }
+
+        const char* c_str() const {
+#if ARX_HAVE_LIBSTDCPLUSPLUS >= 201103L  // Have libstdc++11
+            if (!ext.empty()) return ext.data();
+#endif
+            return buf;
+        }
+        size_t length() const { return len; }
+        bool empty() const { return len == 0; }
+        char operator[](const size_t i) const { return (i < len) ? c_str()[i] : 0; }
+
+        void clear() {
+            len = 0;
+            buf[0] = 0;
+#if ARX_HAVE_LIBSTDCPLUSPLUS >= 201103L  // Have libstdc++11
+            ext.clear();
+#endif
+        }
+        bool assign(const char* s, const size_t n) {
+            clear();
+            return append(s, n);
+        }
+        bool append(const char* s, const size_t n) {
+            char* p = grow(n);
+            if (p && n) memcpy(p, s, n);
+            return p != nullptr;
+        }
+        bool append(const char c, const size_t n = 1) {
+            char* p = grow(n);
+            if (p && n) memset(p, c, n);
+            return p != nullptr;
+        }
+
+    private:
+        // extends the length by n and returns the position to write them
+        char* grow(const size_t n) {
+            const size_t new_len = len + n;
+#if ARX_HAVE_LIBSTDCPLUSPLUS >= 201103L  // Have libstdc++11
+            if (!ext.empty() || (new_len + 1 > N)) {
+                if (ext.empty()) ext.assign(buf, buf + len);
+                ext.resize(new_len + 1);
+                ext[new_len] = 0;
+                char* p = ext.data() + len;
+                len = new_len;
+                return p;
+            }
+#else
+            if (new_len + 1 > N) {
+                LOG_ERROR(F("string size overflow:"), new_len, F("must be <"), N);
+                return nullptr;
+            }
+#endif
+            char* p = buf + len;
+            len = new_len;
+            buf[len] = 0;
+            return p;
+        }
+    };
+
+    using AddressString = InlineString<ARDUINOOSC_MSG_ADDRESS_INLINE_SIZE>;
+    using TypeTagString = InlineString<ARDUINOOSC_MSG_TYPE_TAG_INLINE_SIZE>;
+
     struct Storage {
         Blob data;
 
-        // reserve() makes no sense on arx::stdx::vector because capacity is fixed
-        Storage() { data.reserve(200); }
-
         char* getBytes(const size_t sz) {
             if ((data.size() & 3) != 0) {
                 LOG_ERROR(F("storage size must be 4x bytes but it is"), data.size());
@@ -201,13 +439,56 @@ namespace osc {
         const char* end() const { return begin() ? (begin() + size()) : nullptr; }
         size_t size() const { return data.size(); }
         void assign(const char* beg, const char* end) { data.assign(beg, end); }
+        void resize(const size_t sz) {
+            if (sz < data.size()) data.resize(sz);
+        }
         void clear() { data.clear(); }
     };
 
+    // same interface as Storage over a caller-supplied buffer (e.g. DMA buffer or ring slot)
+    // it never allocates, and getBytes() fails without writing anything if the bytes don't fit
+    struct BufferStorage {
+        char* buf {nullptr};
+        size_t cap {0};
+        size_t len {0};
+
+        BufferStorage() {}
+        BufferStorage(char* buf, const size_t capacity)
+        : buf(buf), cap(capacity) {}
+
+        char* getBytes(const size_t sz) {
+            if ((len & 3) != 0) {
+                LOG_ERROR(F("storage size must be 4x bytes but it is"), len);
+                return nullptr;
+            }
+            const size_t sz4 = ceil4(sz);
+            if (!buf || (len + sz4 > cap)) {
+                LOG_ERROR(F("buffer size overflow:"), len + sz4, F("must be <="), cap);
+                return nullptr;
+            }
+            char* p = buf + len;
+            memset(p + sz, 0, sz4 - sz);  // only the zero padding, the caller writes sz bytes
+            len += sz4;
+            return p;
+        }
+        char* begin() { return buf; }
+        char* end() { return buf ? (buf + len) : nullptr; }
+        const char* begin() const { return buf; }
+        const char* end() const { return buf ? (buf + len) : nullptr; }
+        size_t size() const { return len; }
+        size_t capacity() const { return cap; }
+        void resize(const size_t sz) {
+            if (sz < len) len = sz;
+        }
+        void clear() { len = 0; }
+    };
+
 }  // namespace osc
 }  // namespace arduino
 
 using OscBlob = arduino::osc::Blob;
 using OscTimeTag = arduino::osc::TimeTag;
+using OscStringView = arduino::osc::StringView;
+using OscBlobView = arduino::osc::BlobView;
 
 #endif  // ARDUINOOSC_OSCTYPES_H
@@ -9,6 +9,9 @@
 
 #include "OscMessage.h"
 #include "OscEncoder.h"
+#ifdef ARDUINOOSC_HAVE_THREAD
+#include <mutex>
+#endif
 
 namespace arduino {
 namespace osc {
@@ -20,6 +23,10 @@ namespace osc {
         UdpMapManager& operator=(const UdpMapManager&) = delete;
 
         UdpMap<S> udp_map;
+#ifdef ARDUINOOSC_HAVE_THREAD
+        static constexpr size_t NUM_PACKET_MUTEXES = 8;
+        std::mutex packet_mutexes[NUM_PACKET_MUTEXES];
+#endif
 
     public:
         static UdpMapManager& getInstance() {
@@ -58,6 +65,14 @@ namespace osc {
             }
             return udp_map[port];
         }
+
+#ifdef ARDUINOOSC_HAVE_THREAD
+        // a packet is written into the udp between beginPacket() and endPacket() under this lock
+        // by the concurrent senders (see Client::concurrent())
+        std::mutex& packetMutex(const S* udp) {
+            return packet_mutexes[((uintptr_t)udp >> 4) % NUM_PACKET_MUTEXES];
+        }
+#endif
     };
 
 }  // namespace osc
@@ -13,146 +13,525 @@ namespace osc {
     template <typename T>
     inline T ceil4(const T& p) { return (T)((size_t(p) + 3) & (~size_t(3))); }
 
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define ARDUINOOSC_BIG_ENDIAN
+#endif
+
     template <typename T>
     union PodBytes {
         T value;
         char bytes[sizeof(T)];
     };
 
-    inline bool isBigEndian() {
-        const PodBytes<int32_t> p {0x12345678};
-        return (p.bytes[0] == 0x12);
+    inline constexpr bool isBigEndian() {
+#ifdef ARDUINOOSC_BIG_ENDIAN
+        return true;
+#else
+        return false;
+#endif
     }
 
+    namespace detail {
+        // byte swap by the size of the type, which compiles to bswap/rev instructions
+        template <size_t N>
+        struct ByteSwap {
+            template <typename POD>
+            static POD swap(const POD& v) {
+                PodBytes<POD> src {v}, dst;
+                for (size_t i = 0; i < N; ++i) dst.bytes[i] = src.bytes[N - i - 1];
+                return dst.value;
+            }
+        };
+        template <>
+        struct ByteSwap<1> {
+            template <typename POD>
+            static POD swap(const POD& v) { return v; }
+        };
+        template <>
+        struct ByteSwap<2> {
+            using type = uint16_t;
+            static type swap(const type v) { return __builtin_bswap16(v); }
+        };
+        template <>
+        struct ByteSwap<4> {
+            using type = uint32_t;
+            static type swap(const type v) { return __builtin_bswap32(v); }
+        };
+        template <>
+        struct ByteSwap<8> {
+            using type = uint64_t;
+            static type swap(const type v) { return __builtin_bswap64(v); }
+        };
+
+        template <typename POD, typename = void>
+        struct Endian {
+            // network (big endian) bytes -> host value
+            static POD load(const char* bytes) {
+                POD v;
+                memcpy(&v, bytes, sizeof(POD));
+#ifndef ARDUINOOSC_BIG_ENDIAN
+                v = ByteSwap<sizeof(POD)>::swap(v);
+#endif
+                return v;
+            }
+            static void store(const POD& value, char* bytes) {
+#ifdef ARDUINOOSC_BIG_ENDIAN
+                memcpy(bytes, &value, sizeof(POD));
+#else
+                const POD v = ByteSwap<sizeof(POD)>::swap(value);
+                memcpy(bytes, &v, sizeof(POD));
+#endif
+            }
+        };
+
+        // 2, 4, 8 byte values are swapped as unsigned integers of the same size
+        template <typename POD>
+        struct Endian<POD, typename std::enable_if<(sizeof(POD) == 2) || (sizeof(POD) == 4) || (sizeof(POD) == 8)>::type> {
+            using U = typename ByteSwap<sizeof(POD)>::type;
+            static POD load(const char* bytes) {
+                U u;
+                memcpy(&u, bytes, sizeof(U));
+#ifndef ARDUINOOSC_BIG_ENDIAN
+                u = ByteSwap<sizeof(U)>::swap(u);
+#endif
+                POD v;
+                memcpy(&v, &u, sizeof(U));
+                return v;
+            }
+            static void store(const POD& value, char* bytes) {
+                U u;
+                memcpy(&u, &value, sizeof(U));
+#ifndef ARDUINOOSC_BIG_ENDIAN
+                u = ByteSwap<sizeof(U)>::swap(u);
+#endif
+                memcpy(bytes, &u, sizeof(U));
+            }
+        };
+    }  // namespace detail
+
     template <typename POD>
     inline POD bytes2pod(const char* bytes) {
-        PodBytes<POD> p;
-        for (size_t i = 0; i < sizeof(POD); ++i) {
-            if (isBigEndian())
-                p.bytes[i] = bytes[i];
-            else
-                p.bytes[i] = bytes[sizeof(POD) - i - 1];
-        }
-        return p.value;
+        return detail::Endian<POD>::load(bytes);
     }
 
     template <typename POD>
     inline void pod2bytes(const POD& value, char* bytes) {
-        const PodBytes<POD> p {value};
-        for (size_t i = 0; i < sizeof(POD); ++i) {
-            if (isBigEndian())
-                bytes[i] = p.bytes[i];
-            else
-                bytes[i] = p.bytes[sizeof(POD) - i - 1];
-        }
+        detail::Endian<POD>::store(value, bytes);
     }
 
-    inline const char* internalPatternMatch(const char* pattern, const char* path) {
-        while (*pattern) {
-            const char* p = pattern;
+    // bulk conversion of n values in one pass
+    // the loops have no branches and are vectorized by the compiler where SIMD is available
+    template <typename POD>
+    inline void bytes2pods(const char* __restrict bytes, const size_t n, POD* __restrict values) {
+#ifdef ARDUINOOSC_BIG_ENDIAN
+        memcpy(values, bytes, n * sizeof(POD));
+#else
+        for (size_t i = 0; i < n; ++i) values[i] = detail::Endian<POD>::load(bytes + i * sizeof(POD));
+#endif
+    }
 
-            if ((*p == '?') && *path) {
-                ++p;
-                ++path;
+    template <typename POD>
+    inline void pods2bytes(const POD* __restrict values, const size_t n, char* __restrict bytes) {
+#ifdef ARDUINOOSC_BIG_ENDIAN
+        memcpy(bytes, values, n * sizeof(POD));
+#else
+        for (size_t i = 0; i < n; ++i) detail::Endian<POD>::store(values[i], bytes + i * sizeof(POD));
+#endif
+    }
+
+    // parse dotted decimal "a.b.c.d" into 4 bytes
+    inline bool parseIPv4(const char* str, uint8_t* ip) {
+        for (size_t i = 0; i < 4; ++i) {
+            uint16_t v = 0;
+            size_t digits = 0;
+            while ((*str >= '0') && (*str <= '9') && (digits < 3)) {
+                v = v * 10 + (*str++ - '0');
+                ++digits;
             }
+            if ((digits == 0) || (v > 255)) return false;
+            ip[i] = (uint8_t)v;
+            if (i < 3) {
+                if (*str != '.') return false;
+                ++str;
+            }
+        }
+        return *str == 0;
+    }
 
-            // bracketted range, e.g. [a-zABC]
-            else if ((*p == '[') && *path) {
+#ifndef ARDUINOOSC_PATTERN_MATCH_MAX_LENGTH
+#if ARX_HAVE_LIBSTDCPLUSPLUS >= 201103L  // Have libstdc++11
+#define ARDUINOOSC_PATTERN_MATCH_MAX_LENGTH 255  // longer patterns use heap memory
+#else
+#define ARDUINOOSC_PATTERN_MATCH_MAX_LENGTH 127  // longer patterns never match
+#endif
+#endif
+
+    namespace detail {
+        // test c against the bracketted range at p, e.g. [a-zABC]
+        // end is set to the closing ']' (or the terminating null if there is none)
+        inline bool matchCharClass(const char* p, const char c, const char*& end) {
+            ++p;
+            bool reverse = false;
+            if (*p == '!') {
+                reverse = true;
                 ++p;
-                bool reverse = false;
-                if (*p == '!') {
-                    reverse = true;
-                    ++p;
+            }
+            bool match = reverse;
+            for (; *p && (*p != ']'); ++p) {
+                char c0 = *p, c1 = c0;
+                if ((p[1] == '-') && p[2]) {
+                    p += 2;
+                    c1 = *p;
                 }
-                bool match = reverse;
-                for (; *p && (*p != ']'); ++p) {
-                    char c0 = *p, c1 = c0;
-                    if ((p[1] == '-') && p[2]) {
-                        p += 2;
-                        c1 = *p;
+                if ((c >= c0) && (c <= c1)) {
+                    match = !reverse;
+                }
+            }
+            end = p;
+            return match;
+        }
+
+        // the first alternative of the braced list {foo,bar,baz} at p which is a prefix of s
+        // returns nullptr if none matches, end is the closing '}'
+        inline const char* matchBraceList(const char* p, const char* end, const char* s, size_t& len) {
+            const char* q = p;
+            do {
+                ++q;
+                const char* alt = q;
+                q = strchr(alt, ',');
+                if ((q == 0) || (q > end))
+                    q = end;
+                len = q - alt;
+                if (strncmp(alt, s, len) == 0) return alt;
+            } while (q != end);
+            return nullptr;
+        }
+
+        inline bool isWildcard(const char* p) {
+            return (*p == '*') || ((p[0] == '/') && (p[1] == '/'));
+        }
+
+        // the element after the wildcard at p ('*' or the last '/' of '//')
+        inline const char* skipWildcard(const char* p) {
+            if (*p == '*') {
+                while (*p == '*') ++p;
+                return p;
+            }
+            while (p[1] == '/') ++p;
+            return p;
+        }
+
+        inline const char* furthest(const char* a, const char* b) {
+            return (a > b) ? a : b;
+        }
+
+        // simulates all the ways to match the pattern from a wildcard in one pass over the path,
+        // with the set of positions in the pattern alive at each character of the path
+        // the time is O(pattern length * path length) and there is no recursion
+        // positions inside a braced list have their own bits after the ones of the pattern,
+        // because the characters of the chosen alternative are compared as they are
+        class PatternMatcher {
+            const char* const pattern;
+            const size_t len;
+            const size_t words;
+            uint32_t* curr;  // positions alive at the current character
+            uint32_t* next;  // positions alive at the next character
+            size_t num_next {0};
+            const char* best {nullptr};
+            bool full {false};
+
+            static constexpr size_t NONE = SIZE_MAX;
+
+        public:
+            // bits must have 2 * numWords(len) words
+            PatternMatcher(const char* pattern, const size_t len, uint32_t* bits)
+            : pattern(pattern), len(len), words(numWords(len)), curr(bits), next(bits + numWords(len)) {}
+
+            static constexpr size_t numWords(const size_t len) { return (2 * (len + 1) + 31) / 32; }
+
+            // returns true if the result is settled
+            // or false if only one position is left and it's not a wildcard,
+            // then the match can go on from p and s without the simulation
+            bool run(const char*& p, const char*& s) {
+                memset(curr, 0, 2 * words * sizeof(uint32_t));
+                enter(curr, p, s);
+                size_t num_curr = 1;
+                while (true) {
+                    if (num_curr == 1) {
+                        const size_t i = first(curr, 0);
+                        if (i < len) s = skip(pattern + i, s);
                     }
-                    if ((*path >= c0) && (*path <= c1)) {
-                        match = !reverse;
+                    num_next = 0;
+                    for (size_t i = first(curr, 0); i != NONE; i = first(curr, i + 1)) step(i, s);
+                    if (full || (*s == 0)) return true;
+                    ++s;
+                    uint32_t* tmp = curr;
+                    curr = next;
+                    next = tmp;
+                    memset(next, 0, words * sizeof(uint32_t));
+                    num_curr = num_next;
+                    if (num_curr == 0) return true;
+                    if (num_curr == 1) {
+                        const size_t i = first(curr, 0);
+                        if ((i <= len) && !isWildcard(pattern + i)) {
+                            p = pattern + i;
+                            return false;
+                        }
                     }
                 }
-                if (!match || (*p != ']'))
-                    return pattern;
+            }
 
-                ++p;
-                ++path;
+            // the end of the pattern for a full match, the furthest position where a partial match stopped,
+            // or nullptr if none
+            const char* result() const { return full ? (pattern + len) : best; }
+
+        private:
+            // if only a wildcard is alive, skip the characters which only the wildcard itself can consume
+            static const char* skip(const char* p, const char* s) {
+                if (*p == '*') {
+                    const char* f = skipWildcard(p);
+                    if (!*f || (*f == '?') || (*f == '[') || (*f == '{') || isWildcard(f)) return s;
+                    while (*s && (*s != '/') && (*s != *f)) ++s;
+                } else if ((p[0] == '/') && (p[1] == '/')) {
+                    while (*s && (*s != '/')) ++s;
+                }
+                return s;
             }
 
-            // wildcard '*'
-            else if (*p == '*') {
-                while (*p == '*') ++p;
+            void step(const size_t i, const char* s) {
+                const char c = *s;
 
-                const char* best = 0;
-                while (true) {
-                    const char* ret = internalPatternMatch(p, path);
-                    if (ret && (ret > best))
-                        best = ret;
-                    if ((*path == 0) || (*path == '/'))
-                        break;
+                // in the alternative of a braced list, which was already compared with the path
+                if (i > len) {
+                    const char* p = pattern + (i - len - 1);
+                    if ((p[1] == ',') || (p[1] == '}'))
+                        enter(next, strchr(p + 1, '}') + 1, s + 1);
+                    else
+                        set(next, i + 1);
+                    return;
+                }
+
+                const char* p = pattern + i;
+                if (*p == 0) {
+                    if (c == 0) full = true;
+                }
+
+                else if (*p == '?') {
+                    if (c)
+                        enter(next, p + 1, s + 1);
+                    else
+                        found(p);
+                }
+
+                // bracketted range, e.g. [a-zABC]
+                else if (*p == '[') {
+                    const char* end;
+                    if (c && matchCharClass(p, c, end) && (*end == ']'))
+                        enter(next, end + 1, s + 1);
+                    else
+                        found(p);
+                }
+
+                // wildcard '*', stays here until '/' or the end of the path
+                else if (*p == '*') {
+                    enter(curr, skipWildcard(p), s);
+                    if (c && (c != '/')) set(next, i);
+                }
+
+                // the super-wildcard '//', goes on with the last '/' at every '/' of the path
+                else if ((p[0] == '/') && (p[1] == '/')) {
+                    if (c == '/') enter(curr, skipWildcard(p), s);
+                    if (c) set(next, i);
+                }
+
+                // braced list {foo,bar,baz}, the first alternative which matches is taken
+                else if (*p == '{') {
+                    const char* end = strchr(p, '}');
+                    if (!end) return;  // syntax error in brace list..
+                    size_t n;
+                    const char* alt = matchBraceList(p, end, s, n);
+                    if (!alt)
+                        found(p);
+                    else if (n == 0)
+                        enter(curr, end + 1, s);
                     else
-                        ++path;
+                        set(curr, len + 1 + (alt - pattern));
+                }
+
+                // any other character
+                else if (*p == c) {
+                    enter(next, p + 1, s + 1);
+                }
+
+                else if (c == 0) {
+                    found(p);
                 }
-                return best;
             }
 
-            // the super-wildcard '//'
-            else if ((*p == '/') && (*(p + 1) == '/')) {
-                while (*(p + 1) == '/') ++p;
+            void enter(uint32_t* bits, const char* p, const char* s) {
+                set(bits, p - pattern);
+                // '//' at the end of the path stops at its last '/'
+                if ((p[0] == '/') && (p[1] == '/') && (*s == 0)) found(skipWildcard(p));
+            }
 
-                const char* best = 0;
-                while (true) {
-                    const char* ret = internalPatternMatch(p, path);
-                    if (ret && (ret > best))
-                        best = ret;
-                    if (*path == 0)
-                        break;
-                    if ((*path == 0) || ((path = strchr(path + 1, '/')) == 0))
-                        break;
+            void found(const char* p) {
+                if (!best || (p > best)) best = p;
+            }
+
+            void set(uint32_t* bits, const size_t i) {
+                const uint32_t bit = (uint32_t)1 << (i % 32);
+                if ((bits == next) && !(bits[i / 32] & bit)) ++num_next;
+                bits[i / 32] |= bit;
+            }
+
+            // the first set bit from i, or NONE
+            size_t first(const uint32_t* bits, size_t i) const {
+                size_t w = i / 32;
+                if (w >= words) return NONE;
+                uint32_t b = bits[w] & (~(uint32_t)0 << (i % 32));
+                while (!b) {
+                    if (++w >= words) return NONE;
+                    b = bits[w];
                 }
-                return best;
+                return w * 32 + __builtin_ctzl(b);
             }
+        };
 
-            // braced list {foo,bar,baz}
-            else if (*p == '{') {
-                const char *end = strchr(p, '}'), *q;
-                if (!end) return 0;  // syntax error in brace list..
+        // match from the wildcard at p with PatternMatcher
+        // returns true if the result is settled, otherwise p and s are moved to where the match goes on
+        inline bool matchPatternStates(const char*& p, const char*& s, const char*& result) {
+            static constexpr size_t MAX_LENGTH = ARDUINOOSC_PATTERN_MATCH_MAX_LENGTH;
+            const size_t len = strlen(p);
+            uint32_t bits[2 * PatternMatcher::numWords(MAX_LENGTH)];
+            if (len <= MAX_LENGTH) {
+                PatternMatcher m(p, len, bits);
+                const bool settled = m.run(p, s);
+                result = m.result();
+                return settled;
+            }
+#if ARX_HAVE_LIBSTDCPLUSPLUS >= 201103L  // Have libstdc++11
+            std::vector<uint32_t> heap(2 * PatternMatcher::numWords(len));
+            PatternMatcher m(p, len, &heap.front());
+            const bool settled = m.run(p, s);
+            result = m.result();
+            return settled;
+#else
+            LOG_ERROR(F("pattern is too long:"), p);
+            result = nullptr;
+            return true;
+#endif
+        }
+
+        // match the pattern until a wildcard, where there can be more than one way to go on
+        // returns true if the result is settled, otherwise p and s are moved to the wildcard
+        inline bool matchDirect(const char*& p, const char*& s, const char*& result) {
+            while (*p) {
+                if (isWildcard(p)) return false;
 
-                bool match = false;
-                do {
+                if ((*p == '?') && *s) {
                     ++p;
-                    q = strchr(p, ',');
-                    if ((q == 0) || (q > end))
-                        q = end;
+                    ++s;
+                }
 
-                    if (strncmp(p, path, q - p) == 0) {
-                        path += (q - p);
-                        p = end + 1;
-                        match = true;
-                    } else
-                        p = q;
-                } while ((q != end) && !match);
+                // bracketted range, e.g. [a-zABC]
+                else if ((*p == '[') && *s) {
+                    const char* end;
+                    if (!matchCharClass(p, *s, end) || (*end != ']')) {
+                        result = p;
+                        return true;
+                    }
+                    p = end + 1;
+                    ++s;
+                }
 
-                if (!match) return pattern;
-            }
+                // braced list {foo,bar,baz}
+                else if (*p == '{') {
+                    const char* end = strchr(p, '}');
+                    size_t len;
+                    if (!end) {
+                        result = nullptr;  // syntax error in brace list..
+                        return true;
+                    }
+                    if (!matchBraceList(p, end, s, len)) {
+                        result = p;
+                        return true;
+                    }
+                    s += len;
+                    p = end + 1;
+                }
 
-            // any other character
-            else if (*p == *path) {
-                ++p;
-                ++path;
+                // any other character
+                else if (*p == *s) {
+                    ++p;
+                    ++s;
+                }
+
+                else {
+                    break;
+                }
             }
+            result = (*s == 0) ? p : nullptr;
+            return true;
+        }
 
-            else {
-                break;
+        inline bool hasWildcard(const char* p) {
+            for (; *p; ++p)
+                if (isWildcard(p)) return true;
+            return false;
+        }
+
+        // the last wildcard at p, tries every way to split the path, which is O(path * pattern)
+        inline const char* matchLastWildcard(const char* p, const char* s) {
+            const char* const f = skipWildcard(p);
+            const char* best = nullptr;
+            const bool star = (*p == '*');
+            // the characters which the element after '*' can't begin with are skipped
+            const bool literal = star && *f && (*f != '?') && (*f != '[') && (*f != '{');
+            while (true) {
+                if (!literal || (*s == *f) || (*s == '/') || (*s == 0)) {
+                    const char* q = f;
+                    const char* t = s;
+                    const char* result = nullptr;
+                    matchDirect(q, t, result);
+                    best = furthest(best, result);
+                }
+                if (*s == 0) break;
+                if (star) {
+                    if (*s == '/') break;
+                    ++s;
+                } else if ((s = strchr(s + 1, '/')) == 0) {
+                    break;
+                }
             }
+            return best;
+        }
+    }  // namespace detail
 
-            pattern = p;
+    // returns the end of the pattern if it fully matches the path, the furthest position where
+    // a partial match stopped, or nullptr
+    // the pattern is matched directly until a wildcard, from the last wildcard by trying all the splits,
+    // and otherwise by detail::PatternMatcher while more than one way to match is possible,
+    // so that the stack use is fixed and the time is bounded whatever the path is
+    inline const char* internalPatternMatch(const char* pattern, const char* path) {
+        const char* best = nullptr;
+        const char* result;
+        while (!detail::matchDirect(pattern, path, result)) {
+            if (!detail::hasWildcard(detail::skipWildcard(pattern)))
+                return detail::furthest(best, detail::matchLastWildcard(pattern, path));
+            const bool settled = detail::matchPatternStates(pattern, path, result);
+            best = detail::furthest(best, result);
+            if (settled) return best;
         }
+        return detail::furthest(best, result);
+    }
 
-        return (*path == 0 ? pattern : 0);
+    inline bool partialPatternMatch(const char* pattern, const char* test) {
+        return internalPatternMatch(pattern, test) != 0;
+    }
+
+    inline bool fullPatternMatch(const char* pattern, const char* test) {
+        const char* q = internalPatternMatch(pattern, test);
+        return q && (*q == 0);
     }
 
     inline bool partialPatternMatch(const String& pattern, const String& test) {
@@ -172,6 +551,26 @@ namespace osc {
             return partialPatternMatch(pattern.c_str(), test.c_str());
     }
 
+    // true if the address has any of '?', '*', '[', '{' or the super-wildcard '//'
+    // otherwise the pattern matches only the same address
+    inline bool isAddressPattern(const char* addr) {
+        for (const char* p = addr; *p; ++p) {
+            if ((*p == '?') || (*p == '*') || (*p == '[') || (*p == '{')) return true;
+            if ((*p == '/') && (p[1] == '/')) return true;
+        }
+        return false;
+    }
+
+    // FNV-1a
+    inline uint32_t hashAddress(const char* addr) {
+        uint32_t h = 2166136261UL;
+        for (const char* p = addr; *p; ++p) {
+            h ^= (uint8_t)*p;
+            h *= 16777619UL;
+        }
+        return h;
+    }
+
 }  // namespace osc
 }  // namespace arduino
 
@@ -0,0 +1,431 @@
+// Benchmarks for the message encode / decode paths.
+// Results are printed to Serial. Numbers depend heavily on the board,
+// so compare them only on the same board with the same settings.
+
+#include <ArduinoOSC.h>
+
+#ifndef BENCH_ITERATIONS
+#define BENCH_ITERATIONS 10000
+#endif
+
+OscEncoder bench_encoder;
+OscMessage bench_msg;
+
+void printResult(const char* name, const uint32_t elapsed_us, const uint32_t iterations) {
+    Serial.print(name);
+    Serial.print(" : ");
+    Serial.print((float)elapsed_us * 1000.f / (float)iterations);
+    Serial.println(" ns/op");
+}
+
+void benchMessageLayout() {
+    Serial.print("sizeof(OscMessage) : ");
+    Serial.println((int)sizeof(OscMessage));
+
+    uint32_t begin_us = micros();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; ++i) {
+        OscMessage m("/bench/construct");
+        m.push((int)i).push(1.5f);
+        if (m.size() != 2) Serial.println("Failed");
+    }
+    printResult("construct + push 2 args", micros() - begin_us, BENCH_ITERATIONS);
+
+    bench_msg.init("/bench/decode").push(1).push(2.f).push("three");
+    bench_encoder.init().encode(bench_msg);
+    OscDecoder decoder;
+    begin_us = micros();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; ++i) {
+        decoder.init(bench_encoder.data(), bench_encoder.size());
+        OscMessage* m = decoder.decode();
+        if (!m || m->size() != 3) Serial.println("Failed");
+    }
+    printResult("decode 3 args", micros() - begin_us, BENCH_ITERATIONS);
+}
+
+void benchBulkFloats() {
+    static float frame[256];
+    static float received[256];
+    for (size_t i = 0; i < 256; ++i) frame[i] = (float)i;
+
+    const uint32_t iterations = BENCH_ITERATIONS / 100;
+    uint32_t begin_us = micros();
+    for (uint32_t i = 0; i < iterations; ++i) {
+        bench_msg.init("/bench/frame");
+        for (size_t j = 0; j < 256; ++j) bench_msg.push(frame[j]);
+        bench_encoder.init().encode(bench_msg);
+    }
+    printResult("256 floats push() + encode", micros() - begin_us, iterations);
+
+    begin_us = micros();
+    for (uint32_t i = 0; i < iterations; ++i) {
+        bench_msg.init("/bench/frame").pushFloats(frame, 256);
+        bench_encoder.init().encode(bench_msg);
+    }
+    printResult("256 floats pushFloats() + encode", micros() - begin_us, iterations);
+
+    OscDecoder decoder(bench_encoder.data(), bench_encoder.size());
+    OscMessage* m = decoder.decode();
+    begin_us = micros();
+    for (uint32_t i = 0; i < iterations; ++i) {
+        for (size_t j = 0; j < 256; ++j) received[j] = m->arg<float>(j);
+        if (received[i & 0xFF] != frame[i & 0xFF]) Serial.println("Failed");
+    }
+    printResult("256 floats arg<float>()", micros() - begin_us, iterations);
+
+    begin_us = micros();
+    for (uint32_t i = 0; i < iterations; ++i) {
+        m->copyFloats(received, 0, 256);
+        if (received[i & 0xFF] != frame[i & 0xFF]) Serial.println("Failed");
+    }
+    printResult("256 floats copyFloats()", micros() - begin_us, iterations);
+    if (memcmp(frame, received, sizeof(frame)) != 0) Serial.println("Failed");
+}
+
+void benchEncode() {
+    const size_t num_args[] = {1, 2, 4, 8, 16};
+    for (size_t n : num_args) {
+        // half int32, half float, which is typical for control messages
+        uint32_t bytes = 0;
+        const uint32_t begin_us = micros();
+        for (uint32_t i = 0; i < BENCH_ITERATIONS; ++i) {
+            bench_msg.init("/bench/encode/args");
+            for (size_t j = 0; j < n; ++j) {
+                if (j & 1)
+                    bench_msg.push((float)j);
+                else
+                    bench_msg.push((int32_t)j);
+            }
+            bench_encoder.init().encode(bench_msg);
+            bytes += bench_encoder.size();
+        }
+        const uint32_t elapsed_us = micros() - begin_us;
+        Serial.print("encode ");
+        Serial.print((int)n);
+        Serial.print(" args : ");
+        Serial.print((float)elapsed_us * 1000.f / (float)BENCH_ITERATIONS);
+        Serial.print(" ns/msg, ");
+        Serial.print((float)bytes / (float)elapsed_us);
+        Serial.println(" MB/s");
+    }
+}
+
+// counts the written bytes like a UDP packet which is sent right away
+struct NullStream {
+    uint32_t bytes {0};
+    size_t write(const uint8_t*, size_t sz) {
+        bytes += sz;
+        return sz;
+    }
+};
+
+void benchStreamEncode() {
+    static uint8_t blob[1024];
+    NullStream stream;
+
+    uint32_t begin_us = micros();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; ++i) {
+        bench_msg.init("/bench/stream").push((int32_t)i).push(1.5f).pushBlob(blob, sizeof(blob));
+        bench_encoder.init().encode(bench_msg);
+        stream.write(bench_encoder.data(), bench_encoder.size());
+    }
+    printResult("1KB blob Message + Encoder + write", micros() - begin_us, BENCH_ITERATIONS);
+
+    begin_us = micros();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; ++i) {
+        OscStreamEncoder<NullStream>(stream).encode("/bench/stream", (int32_t)i, 1.5f, OscBlobView(blob, sizeof(blob)));
+    }
+    printResult("1KB blob StreamEncoder", micros() - begin_us, BENCH_ITERATIONS);
+    if (stream.bytes == 0) Serial.println("Failed");
+}
+
+uint64_t bench_now = 0;
+uint64_t benchClock() {
+    return bench_now;
+}
+
+void benchScheduler() {
+    OscScheduler sched;
+    sched.clock(benchClock);
+    uint32_t count = 0;
+    auto f = [&](OscMessage&) { ++count; };
+
+    const uint32_t batch = 32;  // messages held at once
+    const uint32_t iterations = BENCH_ITERATIONS / batch;
+    uint32_t begin_us = micros();
+    for (uint32_t i = 0; i < iterations; ++i) {
+        bench_now = 1;
+        for (uint32_t j = 0; j < batch; ++j) {
+            bench_msg.init("/bench/scheduled", OscTimeTag(1000 + ((j * 7) % batch))).push((int32_t)j);
+            sched.take(bench_msg);
+        }
+        bench_now = 2000;
+        sched.dispatch(f);
+    }
+    printResult("schedule + dispatch", micros() - begin_us, iterations * batch);
+    if (count != iterations * batch) Serial.println("Failed");
+}
+
+void benchDispatch() {
+    // a mixer-like address space with a few pattern subscriptions
+    static int values[64];
+    static int any_mute = 0, any_pan = 0;
+    arduino::osc::server::CallbackMap callbacks;
+    for (int i = 0; i < 64; ++i) {
+        String addr = "/mixer/track/" + String(i) + "/volume";
+        callbacks.insert({addr, arduino::osc::server::make_element_ref(values[i])});
+    }
+    callbacks.insert({"/mixer/track/*/mute", arduino::osc::server::make_element_ref(any_mute)});
+    callbacks.insert({"/mixer/track/*/pan", arduino::osc::server::make_element_ref(any_pan)});
+    OscDispatchIndex index;
+    index.build(callbacks);
+
+    bench_msg.init("/mixer/track/42/volume").push(1);
+    uint32_t begin_us = micros();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; ++i) {
+        for (auto& c : callbacks)
+            if (bench_msg.match(c.first)) c.second->decodeFrom(bench_msg);
+    }
+    printResult("dispatch linear match (66 subs)", micros() - begin_us, BENCH_ITERATIONS);
+
+    begin_us = micros();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; ++i) {
+        index.lookup(bench_msg.addressCStr(), [](arduino::osc::server::element::Base* e) { e->decodeFrom(bench_msg); });
+    }
+    printResult("dispatch index (66 subs)", micros() - begin_us, BENCH_ITERATIONS);
+    if (values[42] != 1) Serial.println("Failed");
+
+    // steady traffic to an address which only a pattern matches
+    OscDispatchCache cache;
+    cache.resize(32);
+    bench_msg.init("/mixer/track/42/mute").push(1);
+    begin_us = micros();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; ++i) {
+        index.lookup(bench_msg.addressCStr(), [](arduino::osc::server::element::Base* e) { e->decodeFrom(bench_msg); });
+    }
+    printResult("dispatch index, pattern (66 subs)", micros() - begin_us, BENCH_ITERATIONS);
+
+    begin_us = micros();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; ++i) {
+        cache.lookup(index, bench_msg.addressCStr(), [](arduino::osc::server::element::Base* e) { e->decodeFrom(bench_msg); });
+    }
+    printResult("dispatch cache, pattern (66 subs)", micros() - begin_us, BENCH_ITERATIONS);
+    if (any_mute != 1) Serial.println("Failed");
+}
+
+#if ARX_HAVE_LIBSTDCPLUSPLUS >= 201103L
+void benchMessagePatterns() {
+    // 32 channels * 8 parameters, and a controller which sends "/ch/*/mute"
+    static const char* params[] = {"mute", "fader", "pan", "gain", "eq/1", "eq/2", "eq/3", "solo"};
+    static int values[256];
+    arduino::osc::server::CallbackMap callbacks;
+    for (int i = 0; i < 32; ++i)
+        for (int j = 0; j < 8; ++j)
+            callbacks.insert({"/ch/" + String(i) + "/" + params[j], arduino::osc::server::make_element_ref(values[i * 8 + j])});
+    OscDispatchIndex index;
+    index.build(callbacks, true);
+
+    bench_msg.init("/ch/*/mute").push(1);
+    uint32_t matched = 0;
+    uint32_t begin_us = micros();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; ++i) {
+        for (auto& c : callbacks)
+            if (ArduinoOSC::fullPatternMatch(bench_msg.addressCStr(), c.first.c_str())) ++matched;
+    }
+    printResult("message pattern, all subs (256 subs)", micros() - begin_us, BENCH_ITERATIONS);
+
+    uint32_t matched_tree = 0;
+    begin_us = micros();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; ++i) {
+        index.lookup(bench_msg.addressCStr(), [&](arduino::osc::server::element::Base*) { ++matched_tree; });
+    }
+    printResult("message pattern, method tree (256 subs)", micros() - begin_us, BENCH_ITERATIONS);
+
+    bench_msg.init("/ch/1?/{mute,solo}").push(1);
+    begin_us = micros();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; ++i) {
+        index.lookup(bench_msg.addressCStr(), [&](arduino::osc::server::element::Base*) { ++matched_tree; });
+    }
+    printResult("message pattern, method tree, 20 matches", micros() - begin_us, BENCH_ITERATIONS);
+    if ((matched != 32 * BENCH_ITERATIONS) || (matched_tree != 52 * BENCH_ITERATIONS)) Serial.println("Failed");
+}
+
+void benchPatterns() {
+    // wildcard subscriptions only, which are all checked for every message without the automaton
+    static const char* fixed_patterns[] = {"/mixer/*/gain", "/mixer/*/mute", "/mixer/*/pan", "/fx/{reverb,delay,chorus}/*", "//ping"};
+    String patterns[37];
+    for (int i = 0; i < 32; ++i) patterns[i] = "/bank/" + String(i) + "/*/level";
+    for (int i = 0; i < 5; ++i) patterns[32 + i] = fixed_patterns[i];
+    OscPatternAutomaton automaton;
+    for (uint32_t i = 0; i < 37; ++i) automaton.add(patterns[i].c_str(), i);
+
+    const char* addrs[] = {"/bank/12/ch3/level", "/mixer/track7/gain", "/fx/delay/time", "/unknown/address"};
+    uint32_t matched = 0;
+    uint32_t begin_us = micros();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; ++i) {
+        const char* addr = addrs[i & 3];
+        for (int j = 0; j < 37; ++j)
+            if (ArduinoOSC::fullPatternMatch(patterns[j].c_str(), addr)) ++matched;
+    }
+    printResult("37 patterns fullPatternMatch", micros() - begin_us, BENCH_ITERATIONS);
+
+    uint32_t matched_automaton = 0;
+    begin_us = micros();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; ++i) {
+        automaton.match(addrs[i & 3], [&](uint32_t) { ++matched_automaton; });
+    }
+    printResult("37 patterns automaton", micros() - begin_us, BENCH_ITERATIONS);
+    if (matched != matched_automaton) Serial.println("Failed");
+}
+// udp which discards the packets
+struct NullUdp {
+    uint8_t begin(const uint16_t) { return 1; }
+    void stop() {}
+    uint16_t localPort() const { return 0; }
+    int beginPacket(const char*, uint16_t) { return 1; }
+    int beginPacket(IPAddress, uint16_t) { return 1; }
+    size_t write(const uint8_t*, const size_t n) { return n; }
+    size_t write(uint8_t) { return 1; }
+    int endPacket() { return 1; }
+};
+
+void benchPublish() {
+    // 1000 published values at 1, 10, 30, 60 and 120 fps
+    static const float fps[] = {1.f, 10.f, 30.f, 60.f, 120.f};
+    static int32_t values[1000];
+    OscClientManager<NullUdp>& manager = OscClientManager<NullUdp>::getInstance();
+    std::vector<std::pair<arduino::osc::client::Destination, OscPublishElementRef>> publishers;
+    for (int i = 0; i < 1000; ++i) {
+        const String addr = String("/value/") + String(i);
+        OscPublishElementRef ref = manager.publish("127.0.0.1", 54346, addr, values[i]);
+        ref->setFrameRate(fps[i % 5]);
+        publishers.push_back(std::make_pair(arduino::osc::client::Destination("127.0.0.1", 54346, addr), ref));
+    }
+    const uint32_t duration_us = 500000;
+
+    // every destination is checked in each post() (the former implementation)
+    uint32_t posts = 0;
+    uint32_t begin_us = micros();
+    while ((uint32_t)(micros() - begin_us) < duration_us) {
+        for (auto& p : publishers) {
+            if (p.second->next()) {
+                p.second->last_publish_us = micros();
+                manager.getClient().send(p.first, p.second);
+            }
+        }
+        ++posts;
+    }
+    printResult("post 1k publishers, scan", micros() - begin_us, posts);
+
+    // only the elements which are due are touched
+    posts = 0;
+    begin_us = micros();
+    while ((uint32_t)(micros() - begin_us) < duration_us) {
+        manager.post();
+        ++posts;
+    }
+    printResult("post 1k publishers, deadline heap", micros() - begin_us, posts);
+}
+#endif
+
+#ifdef ARDUINOOSC_HAVE_THREAD
+void benchDispatchWorkers() {
+    // 8 subscriptions with a handler which takes about 20 us (e.g. rebuilding an LED frame)
+    static volatile uint32_t sink = 0;
+    arduino::osc::server::ElementRef elems[8];
+    for (int i = 0; i < 8; ++i) {
+        elems[i] = arduino::osc::server::make_element_ref([](int32_t v) {
+            const uint32_t begin = micros();
+            while ((uint32_t)(micros() - begin) < 20) sink = sink + v;
+        });
+    }
+    OscMessage m("/frame");
+    m.push(1);
+    const uint32_t iterations = BENCH_ITERATIONS / 10;
+
+    uint32_t begin_us = micros();
+    for (uint32_t i = 0; i < iterations; ++i)
+        for (int j = 0; j < 8; ++j) elems[j]->decodeFrom(m);
+    printResult("dispatch 8 heavy subs, in parse()", micros() - begin_us, iterations * 8);
+
+    for (size_t n = 1; n <= 8; n *= 2) {
+        OscDispatchExecutor executor;
+        executor.start(n);
+        begin_us = micros();
+        for (uint32_t i = 0; i < iterations; ++i)
+            for (int j = 0; j < 8; ++j) executor.submit(elems[j].get(), m);
+        executor.wait();
+        const uint32_t elapsed = micros() - begin_us;
+        executor.stop();
+        Serial.print(n);
+        printResult(" workers, dispatch 8 heavy subs", elapsed, iterations * 8);
+    }
+}
+
+// udp which waits about 10 us for the driver to send a packet (e.g. WiFi)
+struct SlowUdp {
+    uint8_t begin(const uint16_t) { return 1; }
+    void stop() {}
+    uint16_t localPort() const { return 0; }
+    int beginPacket(const char*, uint16_t) { return 1; }
+    int beginPacket(IPAddress, uint16_t) { return 1; }
+    size_t write(const uint8_t*, const size_t n) { return n; }
+    size_t write(uint8_t) { return 1; }
+    int endPacket() {
+        std::this_thread::sleep_for(std::chrono::microseconds(10));
+        return 1;
+    }
+};
+
+void benchSendQueue() {
+    // time spent by the caller to send a burst of 32 messages
+    OscClient<SlowUdp> client;
+    const uint32_t bursts = BENCH_ITERATIONS / 100;
+    uint32_t elapsed = 0;
+    for (uint32_t i = 0; i < bursts; ++i) {
+        const uint32_t begin_us = micros();
+        for (int32_t j = 0; j < 32; ++j) client.send("127.0.0.1", 54345, "/burst", j, 1.f);
+        elapsed += micros() - begin_us;
+    }
+    printResult("send burst of 32, sync", elapsed, bursts * 32);
+
+    client.startSendQueue(64);
+    elapsed = 0;
+    for (uint32_t i = 0; i < bursts; ++i) {
+        const uint32_t begin_us = micros();
+        for (int32_t j = 0; j < 32; ++j) client.send("127.0.0.1", 54345, "/burst", j, 1.f);
+        elapsed += micros() - begin_us;
+        while (client.sendQueueStats().depth) delay(1);
+    }
+    const OscSendQueueStats stats = client.sendQueueStats();
+    client.stopSendQueue();
+    printResult("send burst of 32, queued", elapsed, bursts * 32);
+    Serial.print("  max depth ");
+    Serial.print((uint32_t)stats.max_depth);
+    Serial.print(", stalls ");
+    Serial.println(stats.stalls);
+}
+#endif
+
+void setup() {
+    Serial.begin(115200);
+    delay(2000);
+
+    benchMessageLayout();
+    benchBulkFloats();
+    benchEncode();
+    benchStreamEncode();
+    benchScheduler();
+    benchDispatch();
+#if ARX_HAVE_LIBSTDCPLUSPLUS >= 201103L
+    benchMessagePatterns();
+    benchPatterns();
+    benchPublish();
+#endif
+#ifdef ARDUINOOSC_HAVE_THREAD
+    benchDispatchWorkers();
+    benchSendQueue();
+#endif
+}
+
+void loop() {
+}
@@ -90,6 +90,849 @@ void basicTests() {
     Serial.println((pr.decode() == 0) ? "Success" : "Failed");
 }
 
+void viewTests() {
+    OscEncoder wr;
+    OscMessage msg;
+    wr.init().begin_bundle(OscTimeTag(1234));
+    wr.encode(msg.init("/foo").push(1000).push(-1).push("hello").push(1.234f).push(5.678f));
+    wr.begin_bundle(OscTimeTag(5678));
+    wr.encode(msg.init("/bar").push(true).push((double)2.5).pushInt64(-7));
+    wr.end_bundle();
+    wr.end_bundle();
+
+    OscViewDecoder vd(wr.data(), wr.size());
+
+    Serial.println("view decode test: ");
+    const OscMessageView* v = vd.decode();
+    Serial.print("view1  : ");
+    Serial.println((v && v->available() && v->match("/foo") && v->size() == 5 && (uint64_t)v->timeTag() == 1234) ? "Success" : "Failed");
+    Serial.print("args1  : ");
+    Serial.println((v && v->isStr(2) && strcmp(v->arg<const char*>(2), "hello") == 0 && v->arg<float>(4) == 5.678f
+                       && v->arg<int>(0) == 1000 && v->arg<int>(1) == -1 && v->arg<float>(3) == 1.234f
+                       && v->arg<long>(1) == -1 && v->arg<long long>(0) == 1000)
+                       ? "Success"
+                       : "Failed");
+
+    v = vd.decode();
+    Serial.print("view2  : ");
+    Serial.println((v && v->available() && strcmp(v->address(), "/bar") == 0 && strcmp(v->typeTags(), "Tdh") == 0 && (uint64_t)v->timeTag() == 5678) ? "Success" : "Failed");
+    Serial.print("args2  : ");
+    Serial.println((v && v->arg<bool>(0) && v->getArgAsInt64(2) == -7 && v->arg<double>(1) == 2.5
+                    && v->arg<long>(2) == -7 && v->arg<long long>(2) == -7)
+                       ? "Success"
+                       : "Failed");
+
+    Serial.print("view end : ");
+    Serial.println((vd.decode() == nullptr) ? "Success" : "Failed");
+}
+
+void remoteTests() {
+    OscMessage msg("192.168.1.23", 54321, "/remote");
+    Serial.print("remote ip   : ");
+    Serial.println((msg.remoteIP() == "192.168.1.23" && msg.remotePort() == 54321) ? "Success" : "Failed");
+    msg.remoteIP(IPAddress(10, 0, 0, 255));
+    IPAddress ip = msg.remoteIPAddress();
+    Serial.print("remote bin  : ");
+    Serial.println((ip[0] == 10 && ip[3] == 255 && msg.remoteIP() == "10.0.0.255") ? "Success" : "Failed");
+
+    // remoteIP() is formatted when set, and the reference stays valid until the sender changes
+    msg.push(1).push("two");
+    const char* remote = msg.remoteIP().c_str();
+    msg.remoteIP(IPAddress(10, 0, 0, 255));
+    const bool kept = remote == msg.remoteIP().c_str() && strcmp(remote, "10.0.0.255") == 0;
+    msg.init("/changed").push(1.f);
+    Serial.print("accessor refs : ");
+    Serial.println((kept && msg.address() == "/changed" && msg.typeTags() == "f" && strcmp(msg.addressCStr(), "/changed") == 0) ? "Success" : "Failed");
+}
+
+void bulkTests() {
+    float fs[16];
+    int32_t is[4] = {1, -2, 3, -4};
+    for (size_t i = 0; i < 16; ++i) fs[i] = (float)i * 0.5f;
+
+    OscMessage msg;
+    msg.init("/bulk").pushFloats(fs, 16).pushInt32s(is, 4);
+    OscEncoder wr;
+    wr.init().encode(msg);
+
+    OscMessage single;
+    single.init("/bulk");
+    for (size_t i = 0; i < 16; ++i) single.push(fs[i]);
+    for (size_t i = 0; i < 4; ++i) single.push(is[i]);
+    OscEncoder wr_single;
+    wr_single.init().encode(single);
+
+    Serial.print("bulk encode : ");
+    Serial.println((wr.size() == wr_single.size() && memcmp(wr.data(), wr_single.data(), wr.size()) == 0) ? "Success" : "Failed");
+
+    OscDecoder pr(wr.data(), wr.size());
+    OscMessage* mr = pr.decode();
+    float fr[20];
+    int32_t ir[4];
+    size_t nf = mr->copyFloats(fr, 0, 20);
+    size_t ni = mr->copyInt32s(ir, 16, 4);
+    Serial.print("bulk decode : ");
+    Serial.println((nf == 16 && ni == 4 && memcmp(fr, fs, sizeof(fs)) == 0 && memcmp(ir, is, sizeof(is)) == 0) ? "Success" : "Failed");
+}
+
+void zeroCopyTests() {
+    uint8_t blob[5] = {1, 2, 3, 4, 5};
+    OscMessage msg;
+    msg.init("/zero").push("copy").pushBlob(blob, sizeof(blob));
+    OscEncoder wr;
+    wr.init().encode(msg);
+
+    OscDecoder pr(wr.data(), wr.size());
+    OscMessage* mr = pr.decode();
+    OscStringView s = mr->arg<OscStringView>(0);
+    OscBlobView b = mr->arg<OscBlobView>(1);
+    Serial.print("string view : ");
+    Serial.println((s == "copy" && s.size() == 4 && strcmp(mr->arg<const char*>(0), "copy") == 0) ? "Success" : "Failed");
+    Serial.print("blob view   : ");
+    Serial.println((b.size() == sizeof(blob) && memcmp(b.data(), blob, sizeof(blob)) == 0) ? "Success" : "Failed");
+
+    OscMessageView v(wr.data(), wr.size());
+    Serial.print("view blob   : ");
+    Serial.println((v.arg<OscBlobView>(1).size() == sizeof(blob) && v.arg<OscStringView>(0) == "copy") ? "Success" : "Failed");
+}
+
+void schemaTests() {
+    OscSchema<float, float, int> schema("/pose");
+    char buf[64];
+    size_t sz = schema.encode(buf, 1.5f, -2.5f, 7);
+
+    OscMessage msg;
+    msg.init("/pose").push(1.5f).push(-2.5f).push(7);
+    OscEncoder wr;
+    wr.init().encode(msg);
+    Serial.print("schema encode : ");
+    Serial.println((sz == wr.size() && sz == schema.encodedSize(1.5f, -2.5f, 7) && memcmp(buf, wr.data(), sz) == 0) ? "Success" : "Failed");
+
+    OscDecoder pr(wr.data(), wr.size());
+    OscMessage* mr = pr.decode();
+    float x = 0.f, y = 0.f;
+    int i = 0;
+    Serial.print("schema decode : ");
+    Serial.println((schema.decode(*mr, x, y, i) && x == 1.5f && y == -2.5f && i == 7) ? "Success" : "Failed");
+
+    msg.init("/pose").push(1.5f).push(-2.5f).push(7.f);
+    Serial.print("schema reject : ");
+    Serial.println(!OscSchema<float, float, int>::match(msg) ? "Success" : "Failed");
+}
+
+struct BufferStream {
+    uint8_t buf[128];
+    size_t len {0};
+    size_t write(const uint8_t* data, size_t sz) {
+        memcpy(buf + len, data, sz);
+        len += sz;
+        return sz;
+    }
+};
+
+void streamTests() {
+    uint8_t blob[5] = {1, 2, 3, 4, 5};
+    OscMessage msg;
+    msg.init("/stream").push(true).push(3).push(1.5f).push("str").pushBlob(blob, sizeof(blob)).push(2.5);
+    OscEncoder wr;
+    wr.init().encode(msg);
+
+    BufferStream bs;
+    OscStreamEncoder<BufferStream>(bs).encode("/stream", true, 3, 1.5f, "str", OscBlobView(blob, sizeof(blob)), 2.5).flush();
+    Serial.print("stream args    : ");
+    Serial.println((bs.len == wr.size() && memcmp(bs.buf, wr.data(), bs.len) == 0) ? "Success" : "Failed");
+
+    BufferStream bm;
+    OscStreamEncoder<BufferStream>(bm).encode(msg).flush();
+    Serial.print("stream message : ");
+    Serial.println((bm.len == wr.size() && memcmp(bm.buf, wr.data(), bm.len) == 0) ? "Success" : "Failed");
+}
+
+void bufferTests() {
+    OscMessage msg;
+    msg.init("/buffer").push(1).push(2.f);
+    OscEncoder wr;
+    wr.init().encode(msg);
+
+    char buf[64];
+    Serial.print("buffer message  : ");
+    size_t sz = msg.encode(buf, sizeof(buf));
+    Serial.println((sz == wr.size() && memcmp(buf, wr.data(), sz) == 0 && msg.encode(buf, sz - 4) == 0) ? "Success" : "Failed");
+
+    OscEncoder bw(buf, sizeof(buf));
+    bw.begin_bundle().encode(msg);
+    OscEncoder::Checkpoint cp = bw.checkpoint();
+    msg.init("/buffer/too/large").push("this message doesn't fit in the rest of the buffer");
+    bw.encode(msg);
+    const bool overflowed = bw.overflow() && bw.size() == cp.size;
+    bw.rollback(cp).end_bundle();
+
+    msg.init("/buffer").push(1).push(2.f);
+    wr.init().begin_bundle().encode(msg).end_bundle();
+    Serial.print("buffer rollback : ");
+    Serial.println((overflowed && !bw.overflow() && bw.size() == wr.size() && memcmp(bw.data(), wr.data(), wr.size()) == 0) ? "Success" : "Failed");
+
+    // the bundle of the checkpoint is ended before the rollback, which must not truncate it
+    wr.init().begin_bundle().encode(msg);
+    cp = wr.checkpoint();
+    wr.encode(msg).end_bundle();
+    const uint32_t closed = wr.size();
+    wr.rollback(cp);
+    OscDecoder dec(wr.data(), wr.size());
+    int decoded = 0;
+    while (OscMessage* m = dec.decode()) decoded += m->available() ? 1 : 0;
+    Serial.print("rollback after end_bundle : ");
+    Serial.println((wr.overflow() && wr.size() == closed && decoded == 2) ? "Success" : "Failed");
+
+    // a nested bundle which doesn't fit is ended without patching the enclosing one
+    char small[64];
+    OscEncoder nw(small, sizeof(small));
+    msg.init("/");
+    nw.begin_bundle().begin_bundle().encode(msg);  // 16 + (4 + 16) + (4 + 8) bytes
+    nw.begin_bundle().end_bundle();               // needs 20 more bytes
+    nw.encode(msg).end_bundle().end_bundle();     // the second message still fits
+    uint32_t inner = 0;
+    if (nw.size() == 60) inner = arduino::osc::bytes2pod<uint32_t>((const char*)nw.data() + 16);
+    Serial.print("bundle overflow frame : ");
+    Serial.println((nw.overflow() && inner == 40 && nw.checkpoint().depth == 0) ? "Success" : "Failed");
+}
+
+void poolTests() {
+    OscMessage m1("/pool/a"), m2("/pool/b");
+    m1.push(1).push("str");
+    m2.push(2.f);
+    OscEncoder wr;
+    wr.init().begin_bundle().encode(m1).encode(m2).end_bundle();
+
+    // the second packet has less messages and reuses the slots of the first one
+    OscDecoder pr(wr.data(), wr.size());
+    bool ok = pr.decode() && pr.decode() && !pr.decode();
+    wr.init().encode(m2);
+    pr.init(wr.data(), wr.size());
+    OscMessage* mr = pr.decode();
+    ok = ok && mr && mr->address() == "/pool/b" && mr->size() == 1 && mr->arg<float>(0) == 2.f && !pr.decode();
+    Serial.print("decoder pool : ");
+    Serial.println(ok ? "Success" : "Failed");
+}
+
+void walkerTests() {
+    OscMessage msg;
+    OscEncoder wr;
+    wr.init().begin_bundle();
+    for (int i = 0; i < 3; ++i) wr.encode(msg.init("/walk").push(i));
+    wr.end_bundle();
+
+    // break the size of the last element, the messages before it are still decoded
+    uint8_t data[128];
+    memcpy(data, wr.data(), wr.size());
+    data[wr.size() - 20] = 0xFF;
+    OscDecoder pr;
+    bool ok = !pr.init(data, wr.size());
+    OscMessage* m1 = pr.decode();
+    OscMessage* m2 = pr.decode();
+    ok = ok && m1 && m2 && m1->arg<int>(0) == 0 && m2->arg<int>(0) == 1 && !pr.decode();
+    Serial.print("walker corrupted : ");
+    Serial.println(ok ? "Success" : "Failed");
+
+    wr.init();
+    for (int i = 0; i < ARDUINOOSC_MAX_BUNDLE_DEPTH + 1; ++i) wr.begin_bundle();
+    wr.encode(msg.init("/walk/deep").push(1));
+    for (int i = 0; i < ARDUINOOSC_MAX_BUNDLE_DEPTH + 1; ++i) wr.end_bundle();
+    OscBundleWalker walker(wr.data(), wr.size());
+    const char* beg;
+    size_t sz;
+    OscTimeTag tt;
+    Serial.print("walker depth     : ");
+    Serial.println((!walker.next(beg, sz, tt) && walker.corrupted()) ? "Success" : "Failed");
+}
+
+uint64_t test_now = 0;
+uint64_t testClock() {
+    return test_now;
+}
+
+void schedulerTests() {
+    OscScheduler sched;
+    sched.clock(testClock);
+    test_now = 50;
+    OscMessage m;
+    sched.take(m.init("/c", OscTimeTag(300)));
+    sched.take(m.init("/a", OscTimeTag(100)));
+    sched.take(m.init("/b", OscTimeTag(200)));
+    String order;
+    auto f = [&](OscMessage& msg) { order += msg.address(); };
+
+    test_now = 150;
+    bool ok = sched.dispatch(f) == 1 && order == "/a" && sched.size() == 2;
+    test_now = 1000;
+    ok = ok && sched.dispatch(f) == 2 && order == "/a/b/c" && sched.size() == 0;
+    Serial.print("scheduler order : ");
+    Serial.println(ok ? "Success" : "Failed");
+
+    sched.latePolicy(OscLatePolicy::DROP);
+    const bool dropped = sched.take(m.init("/late", OscTimeTag(10)));
+    sched.latePolicy(OscLatePolicy::RUN_NOW);
+    const bool run_now = !sched.take(m.init("/late", OscTimeTag(10)));
+    const bool immediate = !sched.take(m.init("/now"));
+    Serial.print("scheduler late  : ");
+    Serial.println((dropped && run_now && immediate && sched.stats().late == 2 && sched.stats().dropped == 1) ? "Success" : "Failed");
+}
+
+void dispatchTests() {
+    arduino::osc::server::CallbackMap callbacks;
+    int a = 0, b = 0, p = 0;
+    callbacks.insert({"/disp/a", arduino::osc::server::make_element_ref(a)});
+    callbacks.insert({"/disp/b", arduino::osc::server::make_element_ref(b)});
+    callbacks.insert({"/disp/*", arduino::osc::server::make_element_ref(p)});
+    OscDispatchIndex index;
+    index.build(callbacks);
+
+    OscMessage m("/disp/a");
+    m.push(5);
+    index.lookup(m.addressCStr(), [&](arduino::osc::server::element::Base* e) { e->decodeFrom(m); });
+    Serial.print("dispatch index : ");
+    Serial.println((a == 5 && b == 0 && p == 5 && index.numExact() == 2 && index.numPatterns() == 1) ? "Success" : "Failed");
+
+    OscDispatchCache cache;
+    cache.resize(6);  // rounded down to 4
+    auto decode = [&](arduino::osc::server::element::Base* e) { e->decodeFrom(m); };
+    m.clear();
+    m.init("/disp/b").push(7);
+    cache.lookup(index, m.addressCStr(), decode);
+    m.clear();
+    m.init("/disp/b").push(8);
+    cache.lookup(index, m.addressCStr(), decode);
+    const bool cached = (b == 8 && p == 8 && cache.size() == 4 && cache.stats().hits == 1 && cache.stats().misses == 1);
+    callbacks.erase("/disp/*");
+    index.build(callbacks);
+    cache.invalidate();
+    m.clear();
+    m.init("/disp/b").push(9);
+    cache.lookup(index, m.addressCStr(), decode);
+    Serial.print("dispatch cache : ");
+    Serial.println((cached && b == 9 && p == 8 && cache.stats().misses == 2 && cache.stats().invalidations == 1) ? "Success" : "Failed");
+
+    Serial.print("address pattern : ");
+    Serial.println((!ArduinoOSC::isAddressPattern("/a/b") && ArduinoOSC::isAddressPattern("/a/?") && ArduinoOSC::isAddressPattern("//b") && ArduinoOSC::isAddressPattern("/{a,b}")) ? "Success" : "Failed");
+}
+
+void methodTreeTests() {
+    arduino::osc::server::CallbackMap callbacks;
+    int mute[3] = {0, 0, 0}, fader = 0, bus = 0;
+    callbacks.insert({"/ch/1/mute", arduino::osc::server::make_element_ref(mute[0])});
+    callbacks.insert({"/ch/2/mute", arduino::osc::server::make_element_ref(mute[1])});
+    callbacks.insert({"/ch/10/mute", arduino::osc::server::make_element_ref(mute[2])});
+    callbacks.insert({"/ch/1/fader", arduino::osc::server::make_element_ref(fader)});
+    callbacks.insert({"/bus/1/mute", arduino::osc::server::make_element_ref(bus)});
+    OscDispatchIndex index;
+    index.build(callbacks, true);
+
+    OscMessage m;
+    auto send = [&](const char* addr, int v) {
+        m.clear();
+        m.init(addr).push(v);
+        index.lookup(m.addressCStr(), [&](arduino::osc::server::element::Base* e) { e->decodeFrom(m); });
+    };
+    send("/ch/*/mute", 1);
+    const bool star = (mute[0] == 1 && mute[1] == 1 && mute[2] == 1 && fader == 0 && bus == 0);
+    send("/ch/?/mute", 2);
+    const bool question = (mute[0] == 2 && mute[1] == 2 && mute[2] == 1);
+    send("/{ch,bus}/1/{mute,fader}", 3);
+    const bool braces = (mute[0] == 3 && fader == 3 && bus == 3 && mute[1] == 2);
+    send("//mute", 4);
+    const bool any = (mute[0] == 4 && mute[1] == 4 && mute[2] == 4 && bus == 4 && fader == 3);
+    send("/ch/1/fader", 5);
+    Serial.print("method tree : ");
+    Serial.println((star && question && braces && any && fader == 5) ? "Success" : "Failed");
+}
+
+#ifdef ARDUINOOSC_HAVE_THREAD
+void receiveThreadTests() {
+    OscMessageRing ring;
+    ring.resize(6);  // rounded up to 8
+    const int32_t num = 10000;
+    std::thread producer([&] {
+        for (int32_t i = 0; i < num;) {
+            OscMessage* m = ring.back();
+            if (!m) {
+                std::this_thread::yield();
+                continue;
+            }
+            m->clear();
+            m->init("/ring").push(i++);
+            ring.push();
+        }
+    });
+    int32_t expected = 0;
+    bool ordered = true;
+    while (expected < num) {
+        OscMessage* m = ring.front();
+        if (!m) {
+            std::this_thread::yield();
+            continue;
+        }
+        ordered &= (m->arg<int32_t>(0) == expected++);
+        ring.pop();
+    }
+    producer.join();
+    Serial.print("receive queue : ");
+    Serial.println((ordered && ring.empty() && ring.capacity() == 8) ? "Success" : "Failed");
+}
+
+void dispatchExecutorTests() {
+    const int num_subs = 8, num_msgs = 500;
+    int32_t last[num_subs];
+    bool in_order[num_subs];  // written only by the callback of each subscription
+    arduino::osc::server::ElementRef elems[num_subs];
+    for (int i = 0; i < num_subs; ++i) {
+        last[i] = -1;
+        in_order[i] = true;
+        elems[i] = arduino::osc::server::make_element_ref([&, i](int32_t v) {
+            in_order[i] &= (v == last[i] + 1);
+            last[i] = v;
+        });
+    }
+    std::atomic<int> in_flight {0}, unordered_calls {0};
+    bool overlapped = false;
+    arduino::osc::server::ElementRef heavy = arduino::osc::server::make_element_ref([&](int32_t) {
+        overlapped |= (in_flight.fetch_add(1) != 0);
+        std::this_thread::yield();
+        in_flight.fetch_sub(1);
+        ++unordered_calls;
+    });
+    heavy->unordered(true);
+
+    OscDispatchExecutor executor;
+    executor.start(4, 16);
+    OscMessage m;
+    for (int32_t v = 0; v < num_msgs; ++v) {
+        for (int i = 0; i < num_subs; ++i) {
+            m.clear();
+            m.init("/exec").push(v);
+            executor.submit(elems[i].get(), m);
+        }
+        executor.submit(heavy.get(), m);
+    }
+    executor.wait();
+    bool all = (unordered_calls == num_msgs);
+    bool ordered = true;
+    for (int i = 0; i < num_subs; ++i) {
+        all &= (last[i] == num_msgs - 1);
+        ordered &= in_order[i];
+    }
+    const OscDispatchExecutor::Stats stats = executor.stats();
+    executor.stop();
+    Serial.print("dispatch executor : ");
+    Serial.println((ordered && all && !overlapped && stats.executed == (uint32_t)(num_msgs * (num_subs + 1))) ? "Success" : "Failed");
+
+    // wait() from a callback is refused instead of waiting for the callback itself
+    std::atomic<int> refused {0};
+    arduino::osc::server::ElementRef waiter = arduino::osc::server::make_element_ref([&](int32_t) {
+        if (!executor.wait()) ++refused;
+    });
+    executor.start(2, 4);
+    executor.submit(waiter.get(), m);
+    const bool waited = executor.wait();
+    executor.stop();
+    Serial.print("dispatch wait in worker : ");
+    Serial.println((waited && refused == 1) ? "Success" : "Failed");
+}
+
+// keeps the sent packets, one udp is shared by all the sending threads
+struct RecordUdp {
+    static std::vector<std::vector<uint8_t>>& packets() {
+        static std::vector<std::vector<uint8_t>> p;
+        return p;
+    }
+    std::vector<uint8_t> out;
+    uint16_t port {0};
+
+    uint8_t begin(const uint16_t p) {
+        port = p;
+        return 1;
+    }
+    void stop() {}
+    uint16_t localPort() const { return port; }
+    int beginPacket(const char*, uint16_t) {
+        out.clear();
+        return 1;
+    }
+    int beginPacket(IPAddress, uint16_t) {
+        out.clear();
+        return 1;
+    }
+    size_t write(const uint8_t* b, const size_t n) {
+        out.insert(out.end(), b, b + n);
+        return n;
+    }
+    size_t write(const uint8_t b) {
+        out.push_back(b);
+        return 1;
+    }
+    int endPacket() {
+        packets().push_back(out);
+        return 1;
+    }
+};
+
+void concurrentSendTests() {
+    const int num_threads = 4, num_msgs = 500;
+    OscClient<RecordUdp> client(54321);
+    client.concurrent(true);
+    std::vector<std::thread> senders;
+    for (int t = 0; t < num_threads; ++t) {
+        senders.emplace_back([&, t] {
+            const String payload(String("thread") + String(t));
+            for (int32_t i = 0; i < num_msgs; ++i) {
+                if (i % 2)
+                    client.send("127.0.0.1", 54321, "/concurrent", t, i, payload);
+                else {
+                    client.begin_bundle(OscTimeTag::immediate());
+                    client.add_bundle("/concurrent", t, i, payload);
+                    client.end_bundle();
+                    client.send("127.0.0.1", 54321);
+                }
+            }
+        });
+    }
+    for (auto& s : senders) s.join();
+
+    int32_t next[num_threads] = {0};
+    bool intact = RecordUdp::packets().size() == (size_t)(num_threads * num_msgs);
+    OscDecoder decoder;
+    for (auto& p : RecordUdp::packets()) {
+        decoder.init(p.data(), p.size());
+        OscMessage* m = decoder.decode();
+        if (!m || !m->match("/concurrent") || m->size() != 3) {
+            intact = false;
+            continue;
+        }
+        const int32_t t = m->arg<int32_t>(0);
+        if (t < 0 || t >= num_threads) {
+            intact = false;
+            continue;
+        }
+        intact &= (m->arg<int32_t>(1) == next[t]++);
+        intact &= (m->arg<String>(2) == String("thread") + String(t));
+    }
+    Serial.print("concurrent send : ");
+    Serial.println(intact ? "Success" : "Failed");
+}
+
+// the first arguments of the recorded packets
+std::vector<int32_t> recordedArgs() {
+    std::vector<int32_t> args;
+    OscDecoder decoder;
+    for (auto& p : RecordUdp::packets()) {
+        decoder.init(p.data(), p.size());
+        OscMessage* m = decoder.decode();
+        args.push_back((m && m->size()) ? m->arg<int32_t>(0) : -1);
+    }
+    return args;
+}
+
+void sendQueueTests() {
+    // flushed by hand, 6 packets into a queue of 4
+    OscClient<RecordUdp> client(54322);
+    RecordUdp::packets().clear();
+    client.startSendQueue(4, OscSendOverflow::DROP_NEWEST, false);
+    for (int32_t i = 0; i < 6; ++i) client.send("127.0.0.1", 54322, "/queue", i);
+    const bool queued = RecordUdp::packets().empty();
+    OscSendQueueStats stats = client.sendQueueStats();
+    const size_t flushed = client.flush();
+    client.stopSendQueue();
+    Serial.print("send queue drop newest : ");
+    Serial.println((queued && flushed == 4 && stats.dropped == 2 && stats.max_depth == 4 && recordedArgs() == std::vector<int32_t> {0, 1, 2, 3}) ? "Success" : "Failed");
+
+    RecordUdp::packets().clear();
+    client.startSendQueue(4, OscSendOverflow::DROP_OLDEST, false);
+    for (int32_t i = 0; i < 6; ++i) client.send("127.0.0.1", 54322, "/queue", i);
+    stats = client.sendQueueStats();
+    client.stopSendQueue();  // sends the rest
+    Serial.print("send queue drop oldest : ");
+    Serial.println((stats.dropped == 2 && recordedArgs() == std::vector<int32_t> {2, 3, 4, 5}) ? "Success" : "Failed");
+
+    // sent by the flusher thread, the producers wait while the queue is full
+    const int num_threads = 4, num_msgs = 500;
+    RecordUdp::packets().clear();
+    client.startSendQueue(8, OscSendOverflow::BLOCK);
+    std::vector<std::thread> senders;
+    for (int t = 0; t < num_threads; ++t) {
+        senders.emplace_back([&, t] {
+            for (int32_t i = 0; i < num_msgs; ++i) client.send("127.0.0.1", 54322, "/queue", t * num_msgs + i);
+        });
+    }
+    for (auto& s : senders) s.join();
+    client.stopSendQueue();
+    stats = client.sendQueueStats();
+    int32_t next[num_threads];
+    for (int t = 0; t < num_threads; ++t) next[t] = t * num_msgs;
+    bool ordered = RecordUdp::packets().size() == (size_t)(num_threads * num_msgs);
+    for (const int32_t v : recordedArgs()) {
+        const int t = v / num_msgs;
+        ordered &= (v >= 0) && (t < num_threads) && (v == next[t]++);
+    }
+    Serial.print("send queue flusher : ");
+    Serial.println((ordered && stats.dropped == 0 && stats.sent == (uint32_t)(num_threads * num_msgs) && stats.max_depth <= 8) ? "Success" : "Failed");
+}
+#endif
+
+#if ARX_HAVE_LIBSTDCPLUSPLUS >= 201103L
+// serves the packets queued by send() to the server of the port
+struct LoopbackUdp {
+    static std::map<uint16_t, std::deque<std::vector<uint8_t>>>& inbox() {
+        static std::map<uint16_t, std::deque<std::vector<uint8_t>>> q;
+        return q;
+    }
+    static void send(const uint16_t port, const uint8_t* data, const size_t size) {
+        inbox()[port].emplace_back(data, data + size);
+    }
+    std::vector<uint8_t> current;
+    size_t pos {0};
+    uint16_t port {0};
+
+    uint8_t begin(const uint16_t p) {
+        port = p;
+        return 1;
+    }
+    void stop() {}
+    uint16_t localPort() const { return port; }
+    int parsePacket() {
+        std::deque<std::vector<uint8_t>>& q = inbox()[port];
+        current.clear();
+        pos = 0;
+        if (q.empty()) return 0;
+        current = std::move(q.front());
+        q.pop_front();
+        return (int)current.size();
+    }
+    int read(uint8_t* b, const size_t n) {
+        const size_t len = std::min(n, current.size() - pos);
+        memcpy(b, current.data() + pos, len);
+        pos += len;
+        return (int)len;
+    }
+    IPAddress remoteIP() { return IPAddress(127, 0, 0, 1); }
+    uint16_t remotePort() { return 54320; }
+};
+
+void serverReceiveTests() {
+    OscServer<LoopbackUdp> server(54331);
+    int32_t sum = 0;
+    int calls = 0;
+    server.subscribe("/large/packet/address", [&](int32_t a, int32_t b, const String& s) {
+        sum += a + b + (int32_t)s.length();
+        ++calls;
+    });
+
+    // a bundle larger than ARDUINOOSC_MAX_MSG_BYTE_SIZE, which fits in ARDUINOOSC_MAX_RECV_PACKET_SIZE
+    OscEncoder wr;
+    OscMessage m;
+    wr.init().begin_bundle();
+    for (int32_t i = 0; i < 4; ++i) {
+        m.init("/large/packet/address").push(i).push(10).push("padding the message");
+        wr.encode(m);
+    }
+    wr.end_bundle();
+    LoopbackUdp::send(54331, wr.data(), wr.size());
+    server.parse();
+    Serial.print("receive large packet : ");
+    Serial.println((wr.size() > 128 && wr.size() <= ARDUINOOSC_MAX_RECV_PACKET_SIZE && calls == 4 && sum == 6 + 40 + 4 * 19) ? "Success" : "Failed");
+}
+
+void packetTests() {
+    OscServer<LoopbackUdp> server(54332);
+    int calls = 0;
+    server.subscribe("/packet", [&](int32_t, const String&) { ++calls; });
+    const bool by_default = (server.maxPacketSize() == ARDUINOOSC_MAX_RECV_PACKET_SIZE);
+    server.maxPacketSize(SIZE_MAX);
+
+    OscEncoder wr;
+    OscMessage m;
+    wr.init().encode(m.init("/packet").push(42).push("kept for the view"));
+    LoopbackUdp::send(54332, wr.data(), wr.size());
+    server.parse();
+    const uint8_t* received = server.packet();
+    bool kept = (received && server.packetSize() == wr.size() && memcmp(received, wr.data(), wr.size()) == 0);
+
+    // decode the received packet again without copying
+    OscViewDecoder vd(server.packet(), server.packetSize());
+    const OscMessageView* v = vd.decode();
+    kept &= (v && v->match("/packet") && v->arg<int32_t>(0) == 42 && strcmp(v->arg<const char*>(1), "kept for the view") == 0);
+    Serial.print("received packet : ");
+    Serial.println((by_default && kept && calls == 1 && server.maxPacketSize() == ARDUINOOSC_MAX_RECV_PACKET_SIZE) ? "Success" : "Failed");
+
+    // an oversized packet is discarded without dispatching, and the buffer is reused for the next one
+    server.maxPacketSize(wr.size() - 4);
+    LoopbackUdp::send(54332, wr.data(), wr.size());
+    const bool discarded = !server.parse() && !server.packet() && server.packetSize() == 0 && !server.message() && calls == 1;
+    wr.init().encode(m.init("/packet").push(7).push("short"));
+    LoopbackUdp::send(54332, wr.data(), wr.size());
+    const bool next = server.parse() && server.packet() == received && server.packetSize() == wr.size() && calls == 2;
+    Serial.print("discard oversized packet : ");
+    Serial.println((discarded && next) ? "Success" : "Failed");
+}
+
+void parseBudgetTests() {
+    OscServerManager<LoopbackUdp>& manager = OscServerManager<LoopbackUdp>::getInstance();
+    String order;
+    uint32_t busy_us = 0;
+    manager.subscribe(54333, "/a", [&](int32_t) {
+        order += "a";
+        const uint32_t begin_us = micros();
+        while ((uint32_t)(micros() - begin_us) < busy_us) {
+        }
+    });
+    manager.subscribe(54334, "/b", [&](int32_t) { order += "b"; });
+
+    OscEncoder wr;
+    OscMessage m;
+    auto send = [&](const uint16_t port, const char* addr, const size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            wr.init().encode(m.init(addr).push((int32_t)i));
+            LoopbackUdp::send(port, wr.data(), wr.size());
+        }
+    };
+
+    // the busy port doesn't starve the other one, and max_packets stops the drain
+    // each call starts from the first server again
+    send(54333, "/a", 5);
+    send(54334, "/b", 2);
+    const size_t first = manager.parse(3);
+    const String first_order = order;
+    const size_t rest = manager.parse(100);
+    const size_t none = manager.parse(100);
+    Serial.print("parse max packets : ");
+    Serial.println((first == 3 && rest == 4 && none == 0) ? "Success" : "Failed");
+    Serial.print("parse round robin : ");
+    Serial.println((first_order == "aba" && order == "abaabaa") ? "Success" : "Failed");
+
+    // max_micros stops the drain after the packet which ran out of the budget
+    order = "";
+    busy_us = 2000;
+    send(54333, "/a", 3);
+    send(54334, "/b", 3);
+    const size_t timed = manager.parse(100, 1000);
+    const size_t server_timed = manager.getServer(54333).parse(100, 1000);
+    busy_us = 0;
+    const size_t left = manager.parse(100);
+    Serial.print("parse max micros : ");
+    Serial.println((timed == 1 && server_timed == 1 && left == 4 && order == "aaabbb") ? "Success" : "Failed");
+}
+#endif
+
+void publishScheduleTests() {
+    using namespace arduino::osc::client;
+    int32_t fast = 0, slow = 0, rare = 0;
+    DestinationMap dests;
+    dests.insert(std::make_pair(Destination("127.0.0.1", 54323, "/fast"), make_element_ref(fast)));
+    dests.insert(std::make_pair(Destination("127.0.0.1", 54323, "/slow"), make_element_ref(slow)));
+    dests.insert(std::make_pair(Destination("127.0.0.1", 54323, "/rare"), make_element_ref(rare)));
+    dests[Destination("127.0.0.1", 54323, "/fast")]->setIntervalUsec(1000);
+    dests[Destination("127.0.0.1", 54323, "/slow")]->setIntervalUsec(4000);
+    dests[Destination("127.0.0.1", 54323, "/rare")]->setIntervalSec(10.f);
+
+    PublishSchedule schedule;
+    schedule.invalidate();
+    int num_fast = 0, num_slow = 0, num_rare = 0;
+    const uint32_t begin_us = micros();
+    while ((uint32_t)(micros() - begin_us) < 20000) {
+        schedule.post(dests, [&](const Destination& d, const ElementRef&) {
+            if (d.addr == "/fast") ++num_fast;
+            if (d.addr == "/slow") ++num_slow;
+            if (d.addr == "/rare") ++num_rare;
+        });
+    }
+    // about 20 and 5 times in 20 ms, allowing for the preemption of the test
+    Serial.print("publish schedule : ");
+    Serial.println((num_rare == 1 && num_fast >= 10 && num_fast <= 21 && num_slow >= 2 && num_slow <= 6) ? "Success" : "Failed");
+}
+
+void elementTests() {
+    OscElementPool& pool = OscElementPool::getInstance();
+    const size_t used = pool.used();
+    int i = 0;
+    float f = 0.f;
+    OscMessage m("/elem");
+    m.push(3).push(1.5f);
+    {
+        arduino::osc::server::ElementRef values = arduino::osc::server::make_element_ref(i, f);
+        arduino::osc::server::ElementRef func = arduino::osc::server::make_element_ref([&](int a, float b) { i += a; f += b; });
+        arduino::osc::server::ElementRef copy = func;
+        values->decodeFrom(m);
+        copy->decodeFrom(m);
+        Serial.print("element pool : ");
+        Serial.println((i == 6 && f == 3.f && pool.used() == used + 2 && func.use_count() == 2) ? "Success" : "Failed");
+    }
+    Serial.print("element pool release : ");
+    Serial.println((pool.used() == used) ? "Success" : "Failed");
+}
+
+void typeTagTests() {
+    float sum = 0.f;
+    int calls = 0;
+    String last;
+    OscMessage mf("/typed"), mff("/typed"), mi("/typed"), ms("/typed"), mb("/typed");
+    mf.push(1.5f);
+    mff.push(1.f).push(2.f);
+    mi.push(7);
+    ms.push("abc");
+    mb.push(true);
+
+    arduino::osc::server::ElementRef func = arduino::osc::server::make_element_ref([&](float a) { sum += a; ++calls; });
+    func->decodeFrom(mf);
+    func->decodeFrom(mi);  // int is not reinterpreted as float
+    Serial.print("type tag check : ");
+    Serial.println((sum == 1.5f && calls == 1) ? "Success" : "Failed");
+
+    arduino::osc::server::ElementRef str = arduino::osc::server::make_element_ref([&](const String& s) { last = s; });
+    str->decodeFrom(ms);
+    str->decodeFrom(mf);
+    arduino::osc::server::ElementRef flag = arduino::osc::server::make_element_ref([&](bool b) { if (b) ++calls; });
+    flag->decodeFrom(mb);
+    flag->decodeFrom(mi);
+    Serial.print("type tag check string/bool : ");
+    Serial.println((last == "abc" && calls == 2) ? "Success" : "Failed");
+
+    float fv = 0.f;
+    arduino::osc::server::ElementRef one = arduino::osc::server::make_element_ref(fv);
+    one->decodeFrom(mf);
+    one->decodeFrom(mi);  // int is not reinterpreted as float
+    one->decodeFrom(mff);  // nor are two floats
+    std::vector<float> fs;
+    arduino::osc::server::ElementRef all = arduino::osc::server::make_element_ref(fs);
+    all->decodeFrom(mff);
+    Serial.print("type tag check value : ");
+    Serial.println((fv == 1.5f && fs.size() == 2 && fs[1] == 2.f) ? "Success" : "Failed");
+
+    sum = 0.f;
+    calls = 0;
+    arduino::osc::server::ElementRef over = arduino::osc::server::make_element_ref(
+        [&](float a) { sum += a; },
+        [&](float a, float b) { sum += a * b; },
+        [&](const OscMessage&) { ++calls; });
+    over->decodeFrom(mf);
+    over->decodeFrom(mff);
+    over->decodeFrom(mi);  // falls back to the Message& one
+    Serial.print("type tag overloads : ");
+    Serial.println((sum == 3.5f && calls == 1) ? "Success" : "Failed");
+
+    // long and int64_t take both 'i' and 'h', on 32-bit and 64-bit targets
+    long lv = 0;
+    int64_t hv = 0;
+    OscMessage ml("/typed"), mh("/typed");
+    ml.push(5L);
+    mh.push((long long)1 << 40);
+    arduino::osc::server::ElementRef lng = arduino::osc::server::make_element_ref([&](long v) { lv += v; });
+    lng->decodeFrom(ml);
+    lng->decodeFrom(mi);
+    arduino::osc::server::ElementRef i64 = arduino::osc::server::make_element_ref([&](int64_t v) { hv += v; });
+    i64->decodeFrom(mh);
+    i64->decodeFrom(mi);
+    Serial.print("type tag long/int64 : ");
+    Serial.println((lv == 12 && hv == ((int64_t)1 << 40) + 7 && strcmp(ml.typeTagsCStr(), "i") == 0) ? "Success" : "Failed");
+}
+
 void checkMatch(const char* pattern, const char* test, bool expected_match = true) {
     Serial.print("doing fullPatternMatch('");
     Serial.print(pattern);
@@ -100,6 +943,19 @@ void checkMatch(const char* pattern, const char* test, bool expected_match = tru
     Serial.println();
 
     bool m = ArduinoOSC::match(pattern, test);
+#if ARX_HAVE_LIBSTDCPLUSPLUS >= 201103L
+    OscPatternAutomaton automaton;
+    if (automaton.add(pattern, 0)) {
+        bool am = false;
+        automaton.match(test, [&](uint32_t) { am = true; });
+        if (am != m) {
+            Serial.print("unexpected automaton result... ");
+            Serial.print(pattern);
+            Serial.print(" with ");
+            Serial.println(test);
+        }
+    }
+#endif
     if (!expected_match) {
         if (m) {
             Serial.print("unexpected match... ");
@@ -142,6 +998,13 @@ void patternTests() {
     checkMatch("/*o/bar", "/foo/bar");
     checkMatch("/*/*/*/*a***/*/*/*/*/", "/foo/bar/foo/barrrr/foo/bar/foo/barrrr/");
     checkMatch("/*/*/*/**/*/*/*/*/q", "/foo/bar/foo/barrrr/foo/bar/foo/barrrr/p", false);
+
+    // exponential with a backtracking matcher, must finish right away
+    String deep;
+    for (int i = 0; i < 100; ++i) deep += "/a";
+    checkMatch("//*//*//*//*//*//b", (deep + "/c").c_str(), false);
+    checkMatch("//*//*//*//*//*//c", (deep + "/c").c_str());
+    checkMatch("/a*/*a/{a,b}/?//[ab]/a", deep.c_str());
 }
 
 void setup() {
@@ -226,6 +1089,32 @@ void setup() {
     Serial.println("finished");
 
     basicTests();
+    viewTests();
+    remoteTests();
+    bulkTests();
+    zeroCopyTests();
+    schemaTests();
+    streamTests();
+    bufferTests();
+    poolTests();
+    walkerTests();
+    schedulerTests();
+    dispatchTests();
+    methodTreeTests();
+#ifdef ARDUINOOSC_HAVE_THREAD
+    receiveThreadTests();
+    dispatchExecutorTests();
+    concurrentSendTests();
+    sendQueueTests();
+#endif
+#if ARX_HAVE_LIBSTDCPLUSPLUS >= 201103L
+    serverReceiveTests();
+    packetTests();
+    parseBudgetTests();
+#endif
+    publishScheduleTests();
+    elementTests();
+    typeTagTests();
     patternTests();
 }
 